@@ -0,0 +1,86 @@
+# triton_jit_add_kernels(<target>
+#   SOURCE <file.py> FUNCTION <name>
+#   SIGNATURES <signature>...
+#   [NUM_WARPS <n>] [NUM_STAGES <n>]
+#   [ARCHS <arch>...]
+#   [DEPENDS <file>...])
+#
+# Compile a triton jit function at build time for each signature & cuda arch, and embed the
+# cubins into <target>. The generated header `<name>_kernels.h` declares a launch stub
+# `triton_jit_kernels::<name>_<i>` for the i-th signature, e.g.
+#
+#   triton_jit_add_kernels(add_op
+#     SOURCE ${CMAKE_CURRENT_SOURCE_DIR}/add.py FUNCTION binary_pointwise_kernel
+#     SIGNATURES "*fp32:16,*fp32:16,*fp32:16,i64:16,1024"
+#     NUM_WARPS 8 NUM_STAGES 1 ARCHS 80 90)
+#
+# Embedded kernels are found by TritonJITFunction without python, by the file name and the content
+# hash of the source, for the kernels that are not embedded, it falls back to jit compilation as
+# usual. ARCHS defaults to CMAKE_CUDA_ARCHITECTURES.
+# The build machine needs triton, but not a gpu.
+
+set(_TRITON_JIT_KERNELS_LIST_DIR "${CMAKE_CURRENT_LIST_DIR}")
+
+function(triton_jit_add_kernels target)
+  cmake_parse_arguments(ARG "" "SOURCE;FUNCTION;NUM_WARPS;NUM_STAGES" "SIGNATURES;ARCHS;DEPENDS" ${ARGN})
+  if(NOT ARG_SOURCE OR NOT ARG_FUNCTION OR NOT ARG_SIGNATURES)
+    message(FATAL_ERROR "triton_jit_add_kernels: SOURCE, FUNCTION and SIGNATURES are required")
+  endif()
+  if(NOT ARG_NUM_WARPS)
+    set(ARG_NUM_WARPS 4)
+  endif()
+  if(NOT ARG_NUM_STAGES)
+    set(ARG_NUM_STAGES 3)
+  endif()
+  if(NOT ARG_ARCHS)
+    set(ARG_ARCHS ${CMAKE_CUDA_ARCHITECTURES})
+  endif()
+  if(NOT ARG_ARCHS OR ARG_ARCHS STREQUAL "native")
+    message(FATAL_ERROR "triton_jit_add_kernels: ARCHS is required, e.g. ARCHS 80 90")
+  endif()
+  if(NOT Python_EXECUTABLE)
+    find_package(Python REQUIRED COMPONENTS Interpreter)
+  endif()
+
+  # scripts are in the source tree when building with TritonJIT, or in share/ when installed
+  if(EXISTS "${_TRITON_JIT_KERNELS_LIST_DIR}/../scripts/embed_kernels.py")
+    set(script_dir "${_TRITON_JIT_KERNELS_LIST_DIR}/../scripts")
+  else()
+    set(script_dir "${_TRITON_JIT_KERNELS_LIST_DIR}/../../../share/triton_jit/scripts")
+  endif()
+
+  get_filename_component(source "${ARG_SOURCE}" ABSOLUTE)
+  set(out_dir "${CMAKE_CURRENT_BINARY_DIR}/triton_jit_kernels/${target}")
+  set(out_source "${out_dir}/${ARG_FUNCTION}_kernels.cpp")
+  set(out_header "${out_dir}/${ARG_FUNCTION}_kernels.h")
+
+  set(signature_args)
+  foreach(signature IN LISTS ARG_SIGNATURES)
+    list(APPEND signature_args --signature "${signature}")
+  endforeach()
+  set(arch_args)
+  foreach(arch IN LISTS ARG_ARCHS)
+    # 80-real, 90a etc. are cmake's spellings of an arch
+    string(REGEX REPLACE "[^0-9].*$" "" arch "${arch}")
+    list(APPEND arch_args --arch ${arch})
+  endforeach()
+
+  add_custom_command(
+    OUTPUT "${out_source}" "${out_header}"
+    COMMAND ${Python_EXECUTABLE} "${script_dir}/embed_kernels.py" "${source}"
+            --kernel-name ${ARG_FUNCTION}
+            ${signature_args}
+            --num-warps ${ARG_NUM_WARPS}
+            --num-stages ${ARG_NUM_STAGES}
+            ${arch_args}
+            --out-source "${out_source}"
+            --out-header "${out_header}"
+    DEPENDS "${source}" "${script_dir}/embed_kernels.py" "${script_dir}/standalone_compile.py"
+            "${script_dir}/gen_ssig.py" ${ARG_DEPENDS}
+    COMMENT "Compiling triton kernel ${ARG_FUNCTION} for ${target}"
+    VERBATIM)
+
+  target_sources(${target} PRIVATE "${out_source}" "${out_header}")
+  target_include_directories(${target} PUBLIC $<BUILD_INTERFACE:${out_dir}>)
+  target_link_libraries(${target} PRIVATE TritonJIT::triton_jit_core)
+endfunction()
@@ -2,7 +2,7 @@
 
 #include "axpy_op.h"
 #include "c10/cuda/CUDAStream.h"
-#include "triton_jit/triton_jit_function.h"
+#include "triton_jit/torch_adapter.h"
 
 namespace my_ops {
 using namespace triton_jit;
@@ -121,7 +121,7 @@ at::Tensor axpy3_manual(const at::Tensor &x,
   ParameterBuffer buffer;
   const int num_args = 6;
   buffer.reserve(num_args);
-  c10::SmallVector<std::string> signature;
+  SignatureKey signature;
   signature.reserve(num_args);
   ArgHandle handler = {f.get_static_sig(), buffer, signature, 0};
 
@@ -139,8 +139,6 @@ at::Tensor axpy3_manual(const at::Tensor &x,
   handler.handle_arg(tile_size);
   handler.append_scratch();
 
-  std::string full_signature = join_sig(signature);
-
   const unsigned int num_blocks = (n + tile_size - 1) / tile_size;
   // getCurrentCUDAStream ensures that the stream is initialized, a default stream for each device
 
@@ -152,9 +150,9 @@ at::Tensor axpy3_manual(const at::Tensor &x,
   CUdevice device_index;
   checkCudaErrors(cuCtxGetDevice(&device_index));
 
-  const TritonKernel &kernel = f.get_kernel(full_signature, num_warps, num_stages, device_index);
-  c10::SmallVector<void *> ptrs = buffer.get_ptrs();
-  kernel.launch(num_blocks, 1, 1, num_warps, stream, ptrs.data());
+  TritonJITFunction::ScopedKernelUse use(f);
+  const TritonKernel &kernel = f.get_kernel(signature, num_warps, num_stages, device_index);
+  kernel.launch(num_blocks, 1, 1, num_warps, device_index, raw_stream, buffer.ptrs());
   return out;
 }
 
@@ -0,0 +1,19 @@
+import triton
+from triton import language as tl
+
+
+@triton.autotune(
+    configs=[
+        triton.Config({"BLOCK_N": 256}, num_warps=2, num_stages=1),
+        triton.Config({"BLOCK_N": 1024}, num_warps=4, num_stages=1),
+        triton.Config({"BLOCK_N": 4096}, num_warps=8, num_stages=1),
+    ],
+    key=["n"],
+)
+@triton.jit
+def scale_kernel(X, Out, alpha, n, BLOCK_N: tl.constexpr):
+    pid = tl.program_id(0)
+    offsets = pid * BLOCK_N + tl.arange(0, BLOCK_N)
+    mask = offsets < n
+    x = tl.load(X + offsets, mask=mask)
+    tl.store(Out + offsets, x * alpha, mask=mask)
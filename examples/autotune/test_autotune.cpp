@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <string>
+
+#include "c10/cuda/CUDAStream.h"
+#include "torch/torch.h"
+#include "triton_jit/autotuner.h"
+#include "triton_jit/torch_adapter.h"
+
+using namespace triton_jit;
+
+TEST(autotune_test, reads_configs_and_launches_the_best) {
+  TritonAutotuner &tuner = TritonAutotuner::get_instance(std::string("scale.py"), "scale_kernel");
+  ASSERT_EQ(tuner.configs().size(), 3);
+
+  // a deterministic timer that prefers BLOCK_N=1024, it still launches once to check the configs
+  int timed = 0;
+  tuner.set_timer([&](CUstream, const AutotuneConfig &config, const std::function<void()> &launch) {
+    launch();
+    timed++;
+    return std::get<int64_t>(*config.find(4)) == 1024 ? 1.0 : 2.0;
+  });
+
+  int64_t n = 100000;
+  at::Tensor x = at::rand({n}, at::kCUDA);
+  at::Tensor out = at::empty_like(x);
+  int64_t selected = 0;
+  auto grid = [&](const AutotuneConfig &config) {
+    int64_t block = std::get<int64_t>(*config.find(4));
+    selected = block;
+    return std::array<unsigned int, 3> {static_cast<unsigned int>((n + block - 1) / block), 1, 1};
+  };
+  c10::cuda::CUDAStream stream = c10::cuda::getCurrentCUDAStream();
+  CUstream raw_stream = static_cast<CUstream>(stream.stream());
+  tuner(raw_stream, grid, x, out, 2.0f, n);
+  EXPECT_EQ(timed, 3);
+  EXPECT_EQ(selected, 1024);
+  EXPECT_TRUE(torch::allclose(out, x * 2));
+
+  // memoized for the key
+  tuner(raw_stream, grid, x, out, 3.0f, n);
+  EXPECT_EQ(timed, 3);
+  EXPECT_TRUE(torch::allclose(out, x * 3));
+}
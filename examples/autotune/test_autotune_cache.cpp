@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "triton_jit/autotuner.h"
+
+using namespace triton_jit;
+
+// The selection & persistence logic of the autotuner with a deterministic benchmark, no gpu needed
+namespace {
+std::vector<AutotuneConfig> make_configs() {
+  std::vector<AutotuneConfig> configs;
+  for (int64_t block : {256, 1024, 4096}) {
+    AutotuneConfig config;
+    config.constexprs = {{4, block}};
+    config.num_warps = block >= 1024 ? 8 : 4;
+    config.num_stages = 1;
+    configs.push_back(config);
+  }
+  return configs;
+}
+
+// the config with the given block is the fastest
+struct FakeBenchmark {
+  int64_t fastest;
+  int calls = 0;
+
+  double operator()(const AutotuneConfig &config) {
+    calls++;
+    int64_t block = std::get<int64_t>(*config.find(4));
+    return block == fastest ? 1.0 : 2.0 + block * 1e-3;
+  }
+};
+
+int64_t block_of(const AutotuneConfig &config) {
+  return std::get<int64_t>(*config.find(4));
+}
+
+class AutotuneCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path_ = std::filesystem::temp_directory_path() /
+            ("autotune_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) + "_" +
+             ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".jsonl");
+    std::filesystem::remove(path_);
+  }
+  void TearDown() override {
+    std::filesystem::remove(path_);
+  }
+  std::filesystem::path path_;
+};
+}  // namespace
+
+TEST_F(AutotuneCacheTest, selects_the_fastest_config_once_per_key) {
+  AutotuneCache cache("scale.py|scale_kernel|0", make_configs());
+  FakeBenchmark bench {1024};
+  auto benchmark = [&](const AutotuneConfig &c) { return bench(c); };
+
+  EXPECT_EQ(block_of(cache.select("1000,sm80", benchmark)), 1024);
+  EXPECT_EQ(bench.calls, 3);
+  EXPECT_EQ(block_of(cache.select("1000,sm80", benchmark)), 1024);
+  EXPECT_EQ(bench.calls, 3);
+
+  bench.fastest = 4096;
+  EXPECT_EQ(block_of(cache.select("100000,sm80", benchmark)), 4096);
+  EXPECT_EQ(bench.calls, 6);
+}
+
+TEST_F(AutotuneCacheTest, skips_failing_configs) {
+  AutotuneCache cache("scale.py|scale_kernel|0", make_configs());
+  auto benchmark = [](const AutotuneConfig &c) -> double {
+    if (block_of(c) == 256) {
+      throw std::runtime_error("out of resources");
+    }
+    return 1.0 / block_of(c);
+  };
+  EXPECT_EQ(block_of(cache.select("k", benchmark)), 4096);
+
+  auto all_fail = [](const AutotuneConfig &) -> double { throw std::runtime_error("out of resources"); };
+  EXPECT_THROW(cache.select("other", all_fail), std::runtime_error);
+}
+
+TEST_F(AutotuneCacheTest, persists_across_instances) {
+  {
+    AutotuneCache cache("scale.py|scale_kernel|0", make_configs(), path_);
+    FakeBenchmark bench {256};
+    cache.select("1000,sm80", [&](const AutotuneConfig &c) { return bench(c); });
+  }
+  AutotuneCache cache("scale.py|scale_kernel|0", make_configs(), path_);
+  FakeBenchmark bench {4096};
+  EXPECT_EQ(block_of(cache.select("1000,sm80", [&](const AutotuneConfig &c) { return bench(c); })), 256);
+  EXPECT_EQ(bench.calls, 0);
+
+  // records of other functions (or other versions of the source) are not used
+  AutotuneCache other("scale.py|scale_kernel|1", make_configs(), path_);
+  EXPECT_EQ(block_of(other.select("1000,sm80", [&](const AutotuneConfig &c) { return bench(c); })), 4096);
+  EXPECT_EQ(bench.calls, 3);
+}
+
+TEST_F(AutotuneCacheTest, ignores_records_of_removed_configs) {
+  {
+    AutotuneCache cache("scale.py|scale_kernel|0", make_configs(), path_);
+    FakeBenchmark bench {256};
+    cache.select("1000,sm80", [&](const AutotuneConfig &c) { return bench(c); });
+  }
+  std::vector<AutotuneConfig> configs = make_configs();
+  configs.erase(configs.begin());
+  AutotuneCache cache("scale.py|scale_kernel|0", configs, path_);
+  FakeBenchmark bench {1024};
+  EXPECT_EQ(block_of(cache.select("1000,sm80", [&](const AutotuneConfig &c) { return bench(c); })), 1024);
+  EXPECT_EQ(bench.calls, 2);
+}
@@ -0,0 +1,161 @@
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "null_kernels.h"
+#include "torch/torch.h"
+#include "triton_jit/driver.h"
+#include "triton_jit/torch_adapter.h"
+
+using namespace triton_jit;
+
+// Host overhead per launch, with the null driver so that no time is spent in the CUDA driver.
+// Each benchmark runs for kernels of 1, 4, 8 and 16 arguments.
+
+namespace {
+NullDriver null_driver;
+
+template <size_t N>
+std::array<at::Tensor, N> make_tensors() {
+  std::array<at::Tensor, N> tensors;
+  for (at::Tensor &t : tensors) {
+    t = at::empty({16}, at::kFloat);
+  }
+  return tensors;
+}
+
+template <size_t N, typename F, size_t... I>
+void apply_impl(F &&f, const std::array<at::Tensor, N> &tensors, std::index_sequence<I...>) {
+  f(tensors[I]...);
+}
+
+/* call f with the tensors as separate arguments */
+template <size_t N, typename F>
+void apply(F &&f, const std::array<at::Tensor, N> &tensors) {
+  apply_impl<N>(std::forward<F>(f), tensors, std::make_index_sequence<N> {});
+}
+
+TritonJITFunction &function_of(size_t num_args) {
+  return TritonJITFunction::get_instance(null_kernels::SOURCE, null_kernels::function_name(num_args));
+}
+}  // namespace
+
+template <size_t N>
+static void BM_ParameterBuffer(benchmark::State &state) {
+  std::array<void *, N> values {};
+  for (auto _ : state) {
+    ScopedParameterBuffer scoped_buffer(N);
+    ParameterBuffer &buffer = scoped_buffer.get();
+    for (void *v : values) {
+      buffer.push_arg(v);
+    }
+    benchmark::DoNotOptimize(buffer.ptrs());
+  }
+}
+
+template <size_t N>
+static void BM_ArgHandle(benchmark::State &state) {
+  const StaticSignature &ssig = function_of(N).get_static_sig();
+  std::array<at::Tensor, N> tensors = make_tensors<N>();
+  for (auto _ : state) {
+    ScopedParameterBuffer scoped_buffer(N);
+    ParameterBuffer &buffer = scoped_buffer.get();
+    SignatureKey signature;
+    signature.reserve(N);
+    ArgHandle handler = {ssig, buffer, signature, 0};
+    apply<N>([&](const auto &...args) { (handler.handle_arg(args), ...); }, tensors);
+    handler.append_scratch();
+    benchmark::DoNotOptimize(signature.hash());
+  }
+}
+
+template <size_t N>
+static void BM_JoinSig(benchmark::State &state) {
+  std::vector<std::string> parts(N, "*fp32:16");
+  for (auto _ : state) {
+    std::string sig = join_sig(parts);
+    benchmark::DoNotOptimize(sig.data());
+  }
+}
+
+template <size_t N>
+static void BM_KernelLookup(benchmark::State &state) {
+  const TritonJITFunction &f = function_of(N);
+  SignatureKey signature = SignatureKey::from_signature(null_kernels::signature(N));
+  CUdevice device = Driver::get().current_device();
+  for (auto _ : state) {
+    const TritonKernel &kernel =
+        f.get_kernel(signature, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, device);
+    benchmark::DoNotOptimize(&kernel);
+  }
+}
+
+template <size_t N>
+static void BM_Launch(benchmark::State &state) {
+  const TritonJITFunction &f = function_of(N);
+  std::array<at::Tensor, N> tensors = make_tensors<N>();
+  for (auto _ : state) {
+    apply<N>(
+        [&](const auto &...args) {
+          f(nullptr, 1, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, args...);
+        },
+        tensors);
+  }
+}
+
+template <size_t N>
+static void BM_LaunchPacked(benchmark::State &state) {
+  TritonJITFunction &f = function_of(N);
+  f.set_packed_launch(true);
+  std::array<at::Tensor, N> tensors = make_tensors<N>();
+  for (auto _ : state) {
+    apply<N>(
+        [&](const auto &...args) {
+          f(nullptr, 1, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, args...);
+        },
+        tensors);
+  }
+  f.set_packed_launch(false);
+}
+
+template <size_t N>
+static void BM_BoundLaunch(benchmark::State &state) {
+  const TritonJITFunction &f = function_of(N);
+  std::array<at::Tensor, N> tensors = make_tensors<N>();
+  apply<N>(
+      [&](const auto &...args) {
+        auto launcher = f.bind<decltype(args)...>(null_kernels::NUM_WARPS, null_kernels::NUM_STAGES);
+        for (auto _ : state) {
+          launcher(nullptr, 1, 1, 1, args...);
+        }
+      },
+      tensors);
+}
+
+#define HOST_OVERHEAD_BENCHMARK(name) \
+  BENCHMARK_TEMPLATE(name, 1);        \
+  BENCHMARK_TEMPLATE(name, 4);        \
+  BENCHMARK_TEMPLATE(name, 8);        \
+  BENCHMARK_TEMPLATE(name, 16)
+
+HOST_OVERHEAD_BENCHMARK(BM_ParameterBuffer);
+HOST_OVERHEAD_BENCHMARK(BM_ArgHandle);
+HOST_OVERHEAD_BENCHMARK(BM_JoinSig);
+HOST_OVERHEAD_BENCHMARK(BM_KernelLookup);
+HOST_OVERHEAD_BENCHMARK(BM_Launch);
+HOST_OVERHEAD_BENCHMARK(BM_LaunchPacked);
+HOST_OVERHEAD_BENCHMARK(BM_BoundLaunch);
+
+int main(int argc, char **argv) {
+  null_kernels::register_kernels({1, 4, 8, 16});
+  Driver::set(&null_driver);
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
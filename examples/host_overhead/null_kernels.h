@@ -0,0 +1,84 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "fmt/core.h"
+#include "triton_jit/embedded_kernels.h"
+#include "triton_jit/triton_jit_function.h"
+
+// Fake kernels for the null driver: they are registered as embedded ones, so neither python nor
+// a gpu is needed to get them. `ptrs_<n>` takes n fp32 pointers.
+namespace null_kernels {
+
+// the source is not deployed, so the hash is not checked
+inline const char *SOURCE = "null_kernels.py";
+constexpr uint64_t SOURCE_HASH = 0;
+inline const char *METADATA = R"({"shared": 0, "target": {"arch": 80}})";
+constexpr int NUM_WARPS = 4;
+constexpr int NUM_STAGES = 3;
+
+inline std::string function_name(int num_args) {
+  return fmt::format("ptrs_{}", num_args);
+}
+
+inline std::string signature(int num_args) {
+  std::string sig;
+  for (int i = 0; i < num_args; i++) {
+    sig += i == 0 ? "*fp32" : ",*fp32";
+  }
+  return sig;
+}
+
+/* register a function of num_args fp32 pointers, with a kernel of the cubin for arch 80. Kernels of
+ * a function with different num_warps or signatures (e.g. with divisibility hints, signature(n) if
+ * empty) may be registered, and kernels may have metadata of their own. Functions taking other
+ * arguments are registered with their arg_types, all NON_CONSTEXPR if empty */
+inline void register_kernel(const std::string &function,
+                            int num_args,
+                            const std::string &cubin,
+                            int num_warps = NUM_WARPS,
+                            const std::string &kernel_signature = "",
+                            const std::string &metadata = METADATA,
+                            const std::vector<triton_jit::ArgType> &function_arg_types = {}) {
+  // the registry keeps pointers, deques keep the elements in place
+  static std::deque<std::string> strings;
+  static std::deque<std::vector<int>> arg_types;
+  static std::deque<triton_jit::EmbeddedFunction> functions;
+  static std::deque<triton_jit::EmbeddedKernel> kernels;
+
+  const char *name = strings.emplace_back(function).c_str();
+  const char *sig =
+      strings.emplace_back(kernel_signature.empty() ? signature(num_args) : kernel_signature).c_str();
+  const std::string &image = strings.emplace_back(cubin);
+  const char *meta = strings.emplace_back(metadata).c_str();
+  std::vector<int> &types =
+      arg_types.emplace_back(num_args, static_cast<int>(triton_jit::ArgType::NON_CONSTEXPR));
+  for (size_t i = 0; i < function_arg_types.size(); i++) {
+    types[i] = static_cast<int>(function_arg_types[i]);
+  }
+  triton_jit::EmbeddedKernelRegistry &registry = triton_jit::EmbeddedKernelRegistry::get();
+  registry.add_function(functions.emplace_back(
+      triton_jit::EmbeddedFunction {SOURCE, name, SOURCE_HASH, types.data(), num_args}));
+  registry.add_kernel(kernels.emplace_back(triton_jit::EmbeddedKernel {
+      SOURCE,
+      name,
+      SOURCE_HASH,
+      sig,
+      num_warps,
+      NUM_STAGES,
+      80,
+      reinterpret_cast<const unsigned char *>(image.data()),
+      image.size(),
+      meta}));
+}
+
+/* register ptrs_<n> for each n, the content of a cubin identifies its module, so each has its own */
+inline void register_kernels(const std::vector<int> &arg_counts) {
+  for (int n : arg_counts) {
+    register_kernel(function_name(n), n, fmt::format("cubin of {}", function_name(n)));
+  }
+}
+
+}  // namespace null_kernels
@@ -0,0 +1,222 @@
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "null_kernels.h"
+#include "triton_jit/device_ptr.h"
+#include "triton_jit/driver.h"
+#include "triton_jit/triton_jit_function.h"
+
+// launches via DevicePtr, the test links triton_jit_core only, without torch
+using namespace triton_jit;
+
+namespace {
+// a tensor of another framework, passed via an ArgAdapter
+struct Buffer {
+  void *data;
+  TritonType dtype;
+};
+
+alignas(16) float storage[64];
+}  // namespace
+
+namespace triton_jit {
+template <>
+struct ArgAdapter<Buffer> {
+  static constexpr bool is_pointer = true;
+
+  template <typename F>
+  static auto apply(const Buffer &item, F &&f) {
+    return f(DevicePtr<void>(item.data, item.dtype));
+  }
+};
+}  // namespace triton_jit
+
+class DevicePtrTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    null_kernels::register_kernels({2});
+    null_kernels::register_kernel(
+        "ptrs_2", 2, "cubin of aligned ptrs_2", null_kernels::NUM_WARPS, "*fp32:16,*fp32");
+    Driver::set(&driver_);
+  }
+  static void TearDownTestSuite() {
+    Driver::set(nullptr);
+  }
+  void SetUp() override {
+    driver_.clear();
+    driver_.set_recording(true);
+  }
+
+  static NullDriver driver_;
+};
+
+NullDriver DevicePtrTest::driver_;
+
+TEST_F(DevicePtrTest, Launches) {
+  const TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "ptrs_2");
+  f(nullptr,
+    4,
+    1,
+    1,
+    null_kernels::NUM_WARPS,
+    null_kernels::NUM_STAGES,
+    DevicePtr<float>(storage),
+    DevicePtr<void>(storage + 4, TritonType::FP32));
+  f(nullptr,
+    4,
+    1,
+    1,
+    null_kernels::NUM_WARPS,
+    null_kernels::NUM_STAGES,
+    Buffer {storage, TritonType::FP32},
+    DevicePtr<const float>(storage));
+
+  auto launch = f.bind<DevicePtr<float>, Buffer>(null_kernels::NUM_WARPS, null_kernels::NUM_STAGES);
+  launch(nullptr, 4, 1, 1, DevicePtr<float>(storage), Buffer {storage, TritonType::FP32});
+
+  std::vector<NullDriver::LaunchRecord> launches = driver_.launches();
+  ASSERT_EQ(launches.size(), 3);
+  EXPECT_EQ(launches[0].kernel_name, "ptrs_2");
+  EXPECT_EQ(driver_.num_loads(), 1);
+}
+
+TEST_F(DevicePtrTest, BoundLauncherComparesVaryingArguments) {
+  const std::vector<ArgType> types = {
+      ArgType::SPECIALIZED, ArgType::SPECIALIZED, ArgType::NON_CONSTEXPR, ArgType::CONSTEXPR};
+  const std::vector<std::string> signatures = {"*fp32:16,i64:16,i64,8",
+                                               "*fp32,i64:16,i64,8",
+                                               "*fp32:16,i64,i64,8",
+                                               "*fp32:16,i64:1,i64,8",
+                                               "*fp32:16,i64:16,i64,16"};
+  for (const std::string &sig : signatures) {
+    null_kernels::register_kernel("bound_mixed",
+                                  4,
+                                  "cubin of bound_mixed " + sig,
+                                  null_kernels::NUM_WARPS,
+                                  sig,
+                                  null_kernels::METADATA,
+                                  types);
+  }
+  const TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "bound_mixed");
+  auto launch =
+      f.bind<DevicePtr<float>, int64_t, int64_t, int64_t>(null_kernels::NUM_WARPS, null_kernels::NUM_STAGES);
+  launch(nullptr, 1, 1, 1, DevicePtr<float>(storage), 32, 5, 8);
+  // the non-constexpr scalar is not compared
+  launch(nullptr, 1, 1, 1, DevicePtr<float>(storage), 48, 7, 8);
+  launch(nullptr, 1, 1, 1, DevicePtr<float>(storage + 1), 32, 5, 8);
+  launch(nullptr, 1, 1, 1, DevicePtr<float>(storage), 5, 5, 8);
+  launch(nullptr, 1, 1, 1, DevicePtr<float>(storage), 1, 5, 8);
+  launch(nullptr, 1, 1, 1, DevicePtr<float>(storage), 32, 5, 16);
+  launch(nullptr, 1, 1, 1, DevicePtr<float>(storage), 32, 5, 16);
+
+  FunctionMetrics metrics = f.metrics();
+  EXPECT_EQ(metrics.cache_misses, 5);
+  EXPECT_EQ(metrics.cache_hits, 2);
+  ASSERT_EQ(metrics.kernels.size(), 5);
+  for (const KernelMetrics &k : metrics.kernels) {
+    bool launched_twice = k.signature == signatures[0] || k.signature == signatures[4];
+    EXPECT_EQ(k.launches, launched_twice ? 2 : 1) << k.signature;
+  }
+  EXPECT_EQ(driver_.num_launches(), 7);
+}
+
+TEST_F(DevicePtrTest, LaunchMany) {
+  TritonJITFunction &f =
+      TritonJITFunction::get_instance(null_kernels::SOURCE, "ptrs_2", SpecializationPolicy().specialize(0));
+  using Item = LaunchItem<DevicePtr<float>, DevicePtr<float>>;
+  // the third item is not aligned, so it is launched with a kernel of its own
+  std::vector<Item> items = {
+      {1, 1, 1, {DevicePtr<float>(storage), DevicePtr<float>(storage + 1)}},
+      {2, 1, 1, {DevicePtr<float>(storage + 4), DevicePtr<float>(storage + 1)}},
+      {3, 1, 1, {DevicePtr<float>(storage + 1), DevicePtr<float>(storage)}},
+      {4, 1, 1, {DevicePtr<float>(storage + 8), DevicePtr<float>(storage)}},
+  };
+  FunctionMetrics before = f.metrics();
+  f.launch_many(nullptr, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, items);
+  FunctionMetrics after = f.metrics();
+  EXPECT_EQ(after.cache_hits + after.cache_misses - before.cache_hits - before.cache_misses, 4);
+
+  std::vector<NullDriver::LaunchRecord> launches = driver_.launches();
+  ASSERT_EQ(launches.size(), 4);
+  for (size_t i = 0; i < launches.size(); i++) {
+    EXPECT_EQ(launches[i].grid[0], i + 1);
+    EXPECT_EQ(launches[i].params_size, 0);
+  }
+
+  // packed, each item takes as many bytes as a launch of its own
+  f.set_packed_launch(true);
+  f(nullptr,
+    1,
+    1,
+    1,
+    null_kernels::NUM_WARPS,
+    null_kernels::NUM_STAGES,
+    DevicePtr<float>(storage),
+    DevicePtr<float>(storage + 1));
+  f.launch_many(nullptr, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, items);
+  f.set_packed_launch(false);
+  launches = driver_.launches();
+  ASSERT_EQ(launches.size(), 9);
+  EXPECT_GT(launches[4].params_size, 0);
+  for (size_t i = 5; i < launches.size(); i++) {
+    EXPECT_EQ(launches[i].params_size, launches[4].params_size);
+  }
+}
+
+TEST(ArgHandleTest, PointersAreNotConstexprs) {
+  StaticSignature ssig {2, {ArgType::NON_CONSTEXPR, ArgType::CONSTEXPR}, {}};
+  ParameterBuffer buffer;
+  buffer.reserve(2);
+  SignatureKey signature;
+  ArgHandle handler = {ssig, buffer, signature, 0};
+  EXPECT_THROW(handler.handle_args(DevicePtr<float>(storage), DevicePtr<float>(storage)),
+               std::invalid_argument);
+}
+
+TEST(ArgHandleTest, SignatureOfDevicePtrs) {
+  StaticSignature ssig {5, std::vector<ArgType>(5, ArgType::SPECIALIZED), {}};
+  ParameterBuffer buffer;
+  buffer.reserve(5);
+  SignatureKey signature;
+  ArgHandle handler = {ssig, buffer, signature, 0};
+  handler.handle_args(DevicePtr<float16>(reinterpret_cast<float16 *>(storage)),
+                      DevicePtr<const int64_t>(reinterpret_cast<const int64_t *>(storage + 1)),
+                      Buffer {storage, TritonType::BF16},
+                      std::optional<DevicePtr<float>>(),
+                      int64_t(1));
+  EXPECT_EQ(signature.to_signature(), "*fp16:16,*i64,*bf16:16,nullopt,i64:1");
+  // the nullopt and the 1 are not passed
+  EXPECT_EQ(buffer.size(), 3);
+  EXPECT_EQ(*reinterpret_cast<void **>(buffer.ptrs()[1]), storage + 1);
+}
+
+TEST(ArgHandleTest, ConstexprsAreKeyedByValue) {
+  StaticSignature ssig {3, std::vector<ArgType>(3, ArgType::CONSTEXPR), {}};
+  ParameterBuffer buffer;
+  SignatureKey narrow;
+  ArgHandle narrow_handler = {ssig, buffer, narrow, 0};
+  narrow_handler.handle_args(1024u, 0.5, true);
+  SignatureKey wide;
+  ArgHandle wide_handler = {ssig, buffer, wide, 0};
+  wide_handler.handle_args(int64_t(1024), 0.5, true);
+  // the C++ types of integers do not make different kernels
+  EXPECT_EQ(narrow, wide);
+  EXPECT_EQ(narrow.to_signature(), "1024,0.5,true");
+  EXPECT_EQ(SignatureKey::from_signature(narrow.to_signature()), narrow);
+
+  SignatureKey odd;
+  ArgHandle odd_handler = {ssig, buffer, odd, 0};
+  odd_handler.handle_args(uint64_t(1) << 63, 0.1, -3);
+  EXPECT_EQ(SignatureKey::from_signature(odd.to_signature()), odd);
+
+  // floats render as floats, not as the doubles they widen to
+  SignatureKey single;
+  ArgHandle single_handler = {ssig, buffer, single, 0};
+  single_handler.handle_args(0.1f, 1.5f, 3.0f);
+  EXPECT_EQ(single.to_signature(), "0.1,1.5,3");
+  EXPECT_EQ(SignatureKey::from_signature(single.to_signature()).to_signature(), single.to_signature());
+}
@@ -0,0 +1,104 @@
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "null_kernels.h"
+#include "triton_jit/device_ptr.h"
+#include "triton_jit/driver.h"
+#include "triton_jit/launch_attributes.h"
+#include "triton_jit/triton_jit_function.h"
+
+// launch attributes from the metadata of kernels, the samples are in metadata/
+using namespace triton_jit;
+
+namespace {
+std::string read_metadata(const std::string &name) {
+  std::ifstream f(std::string(LAUNCH_METADATA_DIR) + "/" + name);
+  return std::string((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+}
+
+alignas(16) float storage[64];
+}  // namespace
+
+TEST(LaunchAttributesTest, PlainKernel) {
+  LaunchAttributes attributes = LaunchAttributes::from_metadata(read_metadata("add_kernel.json"));
+  EXPECT_TRUE(attributes.plain());
+  EXPECT_EQ(attributes.cluster_size(), 1);
+  CUlaunchAttribute attrs[LaunchAttributes::MAX_ATTRIBUTES];
+  EXPECT_EQ(attributes.fill(attrs), 0);
+  EXPECT_TRUE(LaunchAttributes::from_metadata(null_kernels::METADATA).plain());
+}
+
+TEST(LaunchAttributesTest, NumCtasAndPdl) {
+  LaunchAttributes attributes = LaunchAttributes::from_metadata(read_metadata("matmul_kernel_ctas.json"));
+  EXPECT_FALSE(attributes.plain());
+  EXPECT_EQ(attributes.cluster_dims, (std::array<unsigned int, 3> {2, 1, 1}));
+  EXPECT_FALSE(attributes.cooperative);
+  EXPECT_TRUE(attributes.pdl);
+  EXPECT_EQ(attributes.grid_dims(3, 2, 1), (std::array<unsigned int, 3> {6, 2, 1}));
+
+  CUlaunchAttribute attrs[LaunchAttributes::MAX_ATTRIBUTES];
+  ASSERT_EQ(attributes.fill(attrs), 3);
+  EXPECT_EQ(attrs[0].id, CU_LAUNCH_ATTRIBUTE_CLUSTER_DIMENSION);
+  EXPECT_EQ(attrs[0].value.clusterDim.x, 2);
+  EXPECT_EQ(attrs[0].value.clusterDim.y, 1);
+  EXPECT_EQ(attrs[0].value.clusterDim.z, 1);
+  EXPECT_EQ(attrs[1].id, CU_LAUNCH_ATTRIBUTE_CLUSTER_SCHEDULING_POLICY_PREFERENCE);
+  EXPECT_EQ(attrs[2].id, CU_LAUNCH_ATTRIBUTE_PROGRAMMATIC_STREAM_SERIALIZATION);
+  EXPECT_EQ(attrs[2].value.programmaticStreamSerializationAllowed, 1);
+}
+
+TEST(LaunchAttributesTest, ClusterDims) {
+  LaunchAttributes attributes =
+      LaunchAttributes::from_metadata(read_metadata("matmul_kernel_cluster_dims.json"));
+  EXPECT_EQ(attributes.cluster_dims, (std::array<unsigned int, 3> {2, 2, 1}));
+  EXPECT_FALSE(attributes.pdl);
+  EXPECT_EQ(attributes.grid_dims(3, 2, 1), (std::array<unsigned int, 3> {6, 4, 1}));
+  CUlaunchAttribute attrs[LaunchAttributes::MAX_ATTRIBUTES];
+  ASSERT_EQ(attributes.fill(attrs), 2);
+  EXPECT_EQ(attrs[0].value.clusterDim.y, 2);
+}
+
+TEST(LaunchAttributesTest, CooperativeGrid) {
+  LaunchAttributes attributes =
+      LaunchAttributes::from_metadata(read_metadata("reduce_kernel_cooperative.json"));
+  EXPECT_FALSE(attributes.plain());
+  EXPECT_TRUE(attributes.cooperative);
+  EXPECT_EQ(attributes.grid_dims(5, 1, 1), (std::array<unsigned int, 3> {5, 1, 1}));
+  CUlaunchAttribute attrs[LaunchAttributes::MAX_ATTRIBUTES];
+  ASSERT_EQ(attributes.fill(attrs), 1);
+  EXPECT_EQ(attrs[0].id, CU_LAUNCH_ATTRIBUTE_COOPERATIVE);
+  EXPECT_EQ(attrs[0].value.cooperative, 1);
+}
+
+TEST(LaunchAttributesTest, InvalidMetadata) {
+  EXPECT_THROW(LaunchAttributes::from_metadata(R"({"num_ctas": 0})"), std::invalid_argument);
+  EXPECT_THROW(LaunchAttributes::from_metadata(R"({"cluster_dims": [1, 1, 1, 1]})"), std::invalid_argument);
+}
+
+TEST(LaunchAttributesTest, LaunchesWithAttributes) {
+  NullDriver driver;
+  driver.set_recording(true);
+  Driver::set(&driver);
+  const char *metadata = R"({"shared": 0, "target": {"arch": 80}, "num_ctas": 2, "launch_pdl": true})";
+  null_kernels::register_kernel("clustered", 1, "cubin of clustered", null_kernels::NUM_WARPS, "", metadata);
+  null_kernels::register_kernels({1});
+
+  const TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "clustered");
+  const TritonJITFunction &g = TritonJITFunction::get_instance(null_kernels::SOURCE, "ptrs_1");
+  f(nullptr, 3, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, DevicePtr<float>(storage));
+  g(nullptr, 3, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, DevicePtr<float>(storage));
+
+  std::vector<NullDriver::LaunchRecord> launches = driver.launches();
+  Driver::set(nullptr);
+  ASSERT_EQ(launches.size(), 2);
+  EXPECT_EQ(launches[0].kernel_name, "clustered");
+  // the grid is in programs, the driver scales it by the cluster
+  EXPECT_EQ(launches[0].grid, (std::array<unsigned int, 3> {3, 1, 1}));
+  EXPECT_EQ(launches[0].attributes.cluster_dims, (std::array<unsigned int, 3> {2, 1, 1}));
+  EXPECT_TRUE(launches[0].attributes.pdl);
+  EXPECT_TRUE(launches[1].attributes.plain());
+}
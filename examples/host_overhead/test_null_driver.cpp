@@ -0,0 +1,436 @@
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fmt/core.h"
+#include "gtest/gtest.h"
+#include "null_kernels.h"
+#include "torch/torch.h"
+#include "triton_jit/driver.h"
+#include "triton_jit/torch_adapter.h"
+#include "triton_jit/trace.h"
+
+using namespace triton_jit;
+
+class NullDriverTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    null_kernels::register_kernels({1, 4});
+    Driver::set(&driver_);
+  }
+  static void TearDownTestSuite() {
+    Driver::set(nullptr);
+  }
+  void SetUp() override {
+    driver_.clear();
+    driver_.set_recording(true);
+  }
+
+  static NullDriver driver_;
+};
+
+NullDriver NullDriverTest::driver_;
+
+TEST_F(NullDriverTest, RecordsLaunches) {
+  const TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "ptrs_1");
+  at::Tensor x = at::empty({16}, at::kFloat);
+  CUstream stream = reinterpret_cast<CUstream>(0x10);
+  f(stream, 3, 2, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, x);
+  f(stream, 5, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, x);
+
+  std::vector<NullDriver::LaunchRecord> launches = driver_.launches();
+  ASSERT_EQ(launches.size(), 2);
+  EXPECT_EQ(launches[0].kernel_name, "ptrs_1");
+  EXPECT_EQ(launches[0].grid, (std::array<unsigned int, 3> {3, 2, 1}));
+  EXPECT_EQ(launches[0].block_x, 32 * null_kernels::NUM_WARPS);
+  EXPECT_EQ(launches[0].shared, 0);
+  EXPECT_EQ(launches[0].stream, stream);
+  EXPECT_EQ(launches[1].grid, (std::array<unsigned int, 3> {5, 1, 1}));
+  EXPECT_EQ(driver_.num_launches(), 2);
+}
+
+TEST_F(NullDriverTest, LoadsOncePerKernel) {
+  const TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "ptrs_4");
+  at::Tensor x = at::empty({16}, at::kFloat);
+  uint64_t loads = driver_.num_loads();
+  for (int i = 0; i < 10; i++) {
+    f(nullptr, 1, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, x, x, x, x);
+  }
+  EXPECT_EQ(driver_.num_loads(), loads + 1);
+  EXPECT_EQ(driver_.num_launches(), 10);
+}
+
+TEST_F(NullDriverTest, CountsWithoutRecording) {
+  driver_.set_recording(false);
+  const TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "ptrs_1");
+  at::Tensor x = at::empty({16}, at::kFloat);
+  f(nullptr, 1, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, x);
+  EXPECT_EQ(driver_.num_launches(), 1);
+  EXPECT_TRUE(driver_.launches().empty());
+}
+
+TEST_F(NullDriverTest, SharesKernelsAcrossDevices) {
+  const TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "ptrs_4");
+  SignatureKey signature = SignatureKey::from_signature(null_kernels::signature(4));
+  const TritonKernel &k0 = f.get_kernel(signature, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, 0);
+  const TritonKernel &k1 = f.get_kernel(signature, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, 1);
+  // compiled once for the arch
+  EXPECT_EQ(&k0, &k1);
+
+  // loaded once per device, devices 2 & 3 are not used by other tests
+  at::Tensor x = at::empty({16}, at::kFloat);
+  uint64_t loads = driver_.num_loads();
+  for (CUdevice device : {2, 3, 2, 3}) {
+    driver_.set_device(device);
+    f(nullptr, 1, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, x, x, x, x);
+  }
+  driver_.set_device(0);
+  EXPECT_EQ(driver_.num_loads(), loads + 2);
+  EXPECT_EQ(driver_.num_launches(), 4);
+}
+
+TEST_F(NullDriverTest, SharesModulesOfTheSameCubin) {
+  null_kernels::register_kernel("twin_a", 1, "the same cubin");
+  null_kernels::register_kernel("twin_b", 1, "the same cubin");
+  const TritonJITFunction &a = TritonJITFunction::get_instance(null_kernels::SOURCE, "twin_a");
+  const TritonJITFunction &b = TritonJITFunction::get_instance(null_kernels::SOURCE, "twin_b");
+  at::Tensor x = at::empty({16}, at::kFloat);
+  uint64_t loads = driver_.num_loads();
+  a(nullptr, 1, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, x);
+  b(nullptr, 1, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, x);
+  EXPECT_EQ(driver_.num_loads(), loads + 1);
+
+  std::vector<NullDriver::LaunchRecord> launches = driver_.launches();
+  ASSERT_EQ(launches.size(), 2);
+  EXPECT_EQ(launches[0].kernel_name, "twin_a");
+  EXPECT_EQ(launches[1].kernel_name, "twin_b");
+}
+
+TEST_F(NullDriverTest, PackedLaunch) {
+  TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "ptrs_4");
+  at::Tensor x = at::empty({16}, at::kFloat);
+  f.set_packed_launch(true);
+  f(nullptr, 2, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, x, x, x, x);
+  f.set_packed_launch(false);
+  f(nullptr, 2, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, x, x, x, x);
+
+  std::vector<NullDriver::LaunchRecord> launches = driver_.launches();
+  ASSERT_EQ(launches.size(), 2);
+  // 4 pointers and the scratch pointers
+  EXPECT_GE(launches[0].params_size, 5 * sizeof(void *));
+  EXPECT_EQ(launches[0].params_size % sizeof(void *), 0);
+  EXPECT_EQ(launches[1].params_size, 0);
+}
+
+TEST_F(NullDriverTest, BoundLauncher) {
+  const TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "ptrs_1");
+  auto launcher = f.bind<at::Tensor>(null_kernels::NUM_WARPS, null_kernels::NUM_STAGES);
+  at::Tensor x = at::empty({16}, at::kFloat);
+  for (int i = 0; i < 3; i++) {
+    launcher(nullptr, i + 1, 1, 1, x);
+  }
+  std::vector<NullDriver::LaunchRecord> launches = driver_.launches();
+  ASSERT_EQ(launches.size(), 3);
+  EXPECT_EQ(launches[2].kernel_name, "ptrs_1");
+  EXPECT_EQ(launches[2].grid[0], 3);
+  EXPECT_EQ(launches[2].block_x, 32 * null_kernels::NUM_WARPS);
+}
+
+TEST_F(NullDriverTest, BoundLauncherRemembersKernelsAfterEvictions) {
+  for (int num_warps : {1, 2}) {
+    null_kernels::register_kernel(
+        "bound_churn", 1, fmt::format("cubin of bound_churn {}", num_warps), num_warps);
+  }
+  TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "bound_churn");
+  f.set_max_kernels(1);
+  auto launch = f.bind<at::Tensor>(1, null_kernels::NUM_STAGES);
+  at::Tensor x = at::empty({16}, at::kFloat);
+  const size_t rounds = decltype(launch)::MAX_ENTRIES + 2;
+  for (size_t i = 0; i < rounds; i++) {
+    // the kernel of 2 warps evicts the bound one, which is looked up again and then remembered
+    f(nullptr, 1, 1, 1, 2, null_kernels::NUM_STAGES, x);
+    launch(nullptr, 1, 1, 1, x);
+    launch(nullptr, 1, 1, 1, x);
+  }
+  EXPECT_EQ(f.metrics().evictions, 2 * rounds - 1);
+  EXPECT_EQ(launch.cache_hits(), rounds);
+  f.set_max_kernels(0);
+}
+
+TEST_F(NullDriverTest, BindChecksArguments) {
+  const TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "ptrs_4");
+  EXPECT_THROW(f.bind<at::Tensor>(null_kernels::NUM_WARPS, null_kernels::NUM_STAGES), std::invalid_argument);
+}
+
+TEST_F(NullDriverTest, Metrics) {
+  null_kernels::register_kernel("metered", 1, "cubin of metered");
+  const TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "metered");
+  at::Tensor x = at::empty({16}, at::kFloat);
+  for (int i = 0; i < 3; i++) {
+    f(nullptr, 1, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, x);
+  }
+
+  FunctionMetrics metrics = f.metrics();
+  EXPECT_EQ(metrics.function, "metered");
+  EXPECT_EQ(metrics.cache_misses, 1);
+  EXPECT_EQ(metrics.cache_hits, 2);
+  EXPECT_EQ(metrics.num_signatures, 1);
+  EXPECT_EQ(metrics.compile_time.count, 1);
+  // embedded kernels do not need python
+  EXPECT_EQ(metrics.interpreter_time.count, 0);
+  ASSERT_EQ(metrics.kernels.size(), 1);
+  EXPECT_EQ(metrics.kernels[0].signature, null_kernels::signature(1));
+  EXPECT_EQ(metrics.kernels[0].launches, 3);
+  EXPECT_EQ(metrics.kernels[0].module_load_time.count, 1);
+
+  MetricsSnapshot snapshot = TritonJITFunction::snapshot_metrics();
+  std::string text = snapshot.to_prometheus();
+  EXPECT_NE(text.find("triton_jit_kernel_cache_hits_total{file=\"null_kernels.py\",function=\"metered\"} 2"),
+            std::string::npos);
+  EXPECT_NE(text.find("# TYPE triton_jit_module_load_seconds histogram"), std::string::npos);
+  EXPECT_NE(snapshot.to_json().find("\"function\":\"metered\""), std::string::npos);
+}
+
+TEST_F(NullDriverTest, Trace) {
+  null_kernels::register_kernel("traced", 1, "cubin of traced");
+  Tracer &tracer = Tracer::get();
+  tracer.clear();
+  Tracer::set_enabled(true);
+  const TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "traced");
+  at::Tensor x = at::empty({16}, at::kFloat);
+  f(nullptr, 1, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, x);
+  Tracer::set_enabled(false);
+  f(nullptr, 1, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, x);
+
+  std::string trace = tracer.to_json();
+  EXPECT_NE(trace.find("\"traceEvents\""), std::string::npos);
+  EXPECT_NE(trace.find("\"name\":\"compile\""), std::string::npos);
+  EXPECT_NE(trace.find("\"signature\":\"*fp32\""), std::string::npos);
+  EXPECT_NE(trace.find("\"name\":\"module_load\""), std::string::npos);
+  // one launch, the second one is not traced
+  size_t first = trace.find("\"name\":\"launch\"");
+  ASSERT_NE(first, std::string::npos);
+  EXPECT_EQ(trace.find("\"name\":\"launch\"", first + 1), std::string::npos);
+  tracer.clear();
+}
+
+TEST_F(NullDriverTest, EvictsLeastRecentlyUsedKernels) {
+  for (int num_warps : {1, 2, 4}) {
+    null_kernels::register_kernel("bounded", 1, fmt::format("cubin of bounded {}", num_warps), num_warps);
+  }
+  TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "bounded");
+  f.set_max_kernels(2);
+  at::Tensor x = at::empty({16}, at::kFloat);
+  uint64_t unloads = driver_.num_unloads();
+  f(nullptr, 1, 1, 1, 1, null_kernels::NUM_STAGES, x);
+  f(nullptr, 1, 1, 1, 2, null_kernels::NUM_STAGES, x);
+  f(nullptr, 1, 1, 1, 1, null_kernels::NUM_STAGES, x);
+  // the kernel of 2 warps is the least recently used one
+  f(nullptr, 1, 1, 1, 4, null_kernels::NUM_STAGES, x);
+  EXPECT_EQ(driver_.num_unloads(), unloads + 1);
+
+  FunctionMetrics metrics = f.metrics();
+  EXPECT_EQ(metrics.evictions, 1);
+  ASSERT_EQ(metrics.kernels.size(), 2);
+  for (const KernelMetrics &k : metrics.kernels) {
+    EXPECT_NE(k.num_warps, 2);
+  }
+
+  // it is loaded again on a miss, evicting the kernel of 1 warp
+  f(nullptr, 1, 1, 1, 2, null_kernels::NUM_STAGES, x);
+  metrics = f.metrics();
+  EXPECT_EQ(metrics.cache_misses, 4);
+  EXPECT_EQ(metrics.evictions, 2);
+  EXPECT_EQ(driver_.num_unloads(), unloads + 2);
+  f.set_max_kernels(0);
+}
+
+TEST_F(NullDriverTest, FreesEvictedKernelsOnceUnused) {
+  for (int num_warps : {1, 2}) {
+    null_kernels::register_kernel("retired", 1, fmt::format("cubin of retired {}", num_warps), num_warps);
+  }
+  TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "retired");
+  f.set_max_kernels(1);
+  at::Tensor x = at::empty({16}, at::kFloat);
+  uint64_t unloads = driver_.num_unloads();
+  {
+    TritonJITFunction::ScopedKernelUse use(f);
+    const TritonKernel &kernel = f.get_kernel(null_kernels::signature(1), 1, null_kernels::NUM_STAGES, 0);
+    f(nullptr, 1, 1, 1, 2, null_kernels::NUM_STAGES, x);
+    EXPECT_EQ(f.metrics().evictions, 1);
+    // the evicted kernel is kept while the use is held, it may still be launched
+    EXPECT_EQ(driver_.num_unloads(), unloads);
+    kernel.launch(1, 1, 1, 1, 0, nullptr, nullptr);
+  }
+  EXPECT_EQ(driver_.num_unloads(), unloads + 1);
+  f.set_max_kernels(0);
+}
+
+TEST_F(NullDriverTest, FloatConstexprsFindEmbeddedKernels) {
+  null_kernels::register_kernel("scaled",
+                                2,
+                                "cubin of scaled",
+                                null_kernels::NUM_WARPS,
+                                "*fp32,0.1",
+                                null_kernels::METADATA,
+                                {ArgType::NON_CONSTEXPR, ArgType::CONSTEXPR});
+  const TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "scaled");
+  at::Tensor x = at::empty({16}, at::kFloat);
+  // without python, it is launched only if the embedded kernel is found
+  f(nullptr, 1, 1, 1, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, x, 0.1f);
+  EXPECT_EQ(driver_.num_launches(), 1);
+  FunctionMetrics metrics = f.metrics();
+  ASSERT_EQ(metrics.kernels.size(), 1);
+  EXPECT_EQ(metrics.kernels[0].signature, "*fp32,0.1");
+}
+
+TEST_F(NullDriverTest, CompileOptionsAreNotVariants) {
+  for (int num_warps : {1, 2}) {
+    null_kernels::register_kernel("variants", 1, fmt::format("cubin of variants {}", num_warps), num_warps);
+  }
+  const TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "variants");
+  at::Tensor x = at::empty({16}, at::kFloat);
+  f(nullptr, 1, 1, 1, 1, null_kernels::NUM_STAGES, x);
+  f(nullptr, 1, 1, 1, 2, null_kernels::NUM_STAGES, x);
+  SpecializationReport report = f.specialization_report();
+  EXPECT_EQ(report.num_variants, 1);
+  EXPECT_TRUE(report.arguments.empty());
+}
+
+TEST_F(NullDriverTest, CompileOptions) {
+  const TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "ptrs_1");
+  SignatureKey signature = SignatureKey::from_signature(null_kernels::signature(1));
+  CompileOptions options(null_kernels::NUM_WARPS, null_kernels::NUM_STAGES);
+  EXPECT_EQ(options.to_string(), "num_warps=4;num_stages=3");
+  // the options of num_warps & num_stages are the same kernel
+  EXPECT_EQ(&f.get_kernel(signature, options, 0),
+            &f.get_kernel(signature, null_kernels::NUM_WARPS, null_kernels::NUM_STAGES, 0));
+  at::Tensor x = at::empty({16}, at::kFloat);
+  f(nullptr, 1, 1, 1, options, x);
+  f.bind<at::Tensor>(options)(nullptr, 1, 1, 1, x);
+  EXPECT_EQ(driver_.num_launches(), 2);
+
+  CompileOptions tuned = options;
+  tuned.maxnreg = 128;
+  tuned.launch_pdl = true;
+  tuned.set("debug", false).set("ptx_version", 84);
+  EXPECT_EQ(tuned.to_string(),
+            "num_warps=4;num_stages=3;maxnreg=128;launch_pdl=true;debug=false;ptx_version=84");
+  EXPECT_NE(tuned, options);
+  EXPECT_FALSE((KernelKey {signature, tuned, 80}) == (KernelKey {signature, options, 80}));
+  // embedded kernels are compiled with the default options
+  EmbeddedKernelRegistry &registry = EmbeddedKernelRegistry::get();
+  std::string sig = signature.to_signature();
+  const EmbeddedFunction *embedded = registry.find_function(null_kernels::SOURCE, "ptrs_1");
+  ASSERT_NE(embedded, nullptr);
+  EXPECT_NE(registry.find_kernel(*embedded, sig, options.to_string(), 80), nullptr);
+  EXPECT_EQ(registry.find_kernel(*embedded, sig, tuned.to_string(), 80), nullptr);
+}
+
+TEST_F(NullDriverTest, PoliciesMakeInstances) {
+  const TritonJITFunction &f = TritonJITFunction::get_instance(null_kernels::SOURCE, "ptrs_4");
+  const TritonJITFunction &g =
+      TritonJITFunction::get_instance(null_kernels::SOURCE, "ptrs_4", SpecializationPolicy().specialize(1));
+  EXPECT_NE(&f, &g);
+  EXPECT_EQ(f.get_static_sig().at(1), ArgType::NON_CONSTEXPR);
+  EXPECT_EQ(g.get_static_sig().at(1), ArgType::SPECIALIZED);
+  EXPECT_THROW(
+      TritonJITFunction::get_instance(null_kernels::SOURCE, "ptrs_4", SpecializationPolicy().specialize(4)),
+      std::invalid_argument);
+}
+
+TEST(SpecializationTest, PolicyOverridesSignature) {
+  SpecializationPolicy::Arg aligned;
+  aligned.assume_aligned = true;
+  SpecializationPolicy::Arg never_one;
+  never_one.never_one = true;
+  StaticSignature ssig {3,
+                        {ArgType::SPECIALIZED, ArgType::SPECIALIZED, ArgType::SPECIALIZED},
+                        {aligned, never_one, SpecializationPolicy::Arg {}}};
+  at::Tensor x = at::empty({16}, at::kFloat);
+  ParameterBuffer buffer;
+  buffer.reserve(3);
+  SignatureKey signature;
+  ArgHandle handler = {ssig, buffer, signature, 0};
+  handler.handle_args(x, int64_t(1), int64_t(1));
+  // the last one is 1, so it is not passed
+  EXPECT_EQ(signature.to_signature(), "*fp32:16,i64,i64:1");
+  EXPECT_EQ(buffer.size(), 2);
+
+  // a misaligned pointer breaks the assumption
+  buffer.clear();
+  SignatureKey misaligned;
+  ArgHandle misaligned_handler = {ssig, buffer, misaligned, 0};
+  EXPECT_ANY_THROW(misaligned_handler.handle_arg(x.narrow(0, 1, 8)));
+}
+
+TEST(SpecializationTest, ReportsVaryingArguments) {
+  SpecializationTracker tracker;
+  EXPECT_FALSE(tracker.record("*fp32:16,*fp32:16,i64,64", 2));
+  EXPECT_FALSE(tracker.record("*fp32,*fp32:16,i64,64", 2));
+  // the same signature is one variant
+  EXPECT_FALSE(tracker.record("*fp32,*fp32:16,i64,64", 2));
+  std::optional<SpecializationReport> exceeded = tracker.record("*fp32:16,*fp32:16,i64,128", 2);
+  ASSERT_TRUE(exceeded);
+  EXPECT_EQ(exceeded->num_variants, 3);
+  ASSERT_EQ(exceeded->arguments.size(), 2);
+  EXPECT_EQ(exceeded->arguments[0].index, 0);
+  EXPECT_EQ(exceeded->arguments[0].values[0], std::make_pair(std::string("*fp32:16"), size_t(2)));
+  EXPECT_EQ(exceeded->arguments[1].index, 3);
+  EXPECT_EQ(exceeded->to_string(),
+            "3 variants; argument 0: *fp32:16 (2), *fp32 (1); argument 3: 64 (2), 128 (1)");
+  // reported once
+  EXPECT_FALSE(tracker.record("*fp32,*fp32,i64,128", 2));
+  EXPECT_EQ(tracker.report().num_variants, 4);
+}
+
+TEST(ParameterBufferTest, Layout) {
+  ParameterBuffer buffer;
+  buffer.reserve(3);
+  buffer.push_arg(int32_t(7));
+  buffer.push_arg(int64_t(-1));
+  buffer.push_arg(float(0.5f));
+  EXPECT_EQ(buffer.size(), 3);
+  // the int64 is aligned to 8 bytes
+  EXPECT_EQ(buffer.bytes(), 20);
+  void **ptrs = buffer.ptrs();
+  EXPECT_EQ(*static_cast<int32_t *>(ptrs[0]), 7);
+  EXPECT_EQ(*static_cast<int64_t *>(ptrs[1]), -1);
+  EXPECT_EQ(*static_cast<float *>(ptrs[2]), 0.5f);
+  EXPECT_EQ(static_cast<std::byte *>(ptrs[1]) - static_cast<std::byte *>(buffer.data()), 8);
+}
+
+TEST(ParameterBufferTest, GrowsBeyondInlineCapacity) {
+  ParameterBuffer buffer;
+  buffer.reserve(1);
+  const int n = 3 * ParameterBuffer::INLINE_ARGS;
+  for (int64_t i = 0; i < n; i++) {
+    buffer.push_arg(i);
+  }
+  void **ptrs = buffer.ptrs();
+  for (int64_t i = 0; i < n; i++) {
+    EXPECT_EQ(*static_cast<int64_t *>(ptrs[i]), i);
+  }
+}
+
+TEST(ParameterBufferTest, ScopedBuffersNest) {
+  ScopedParameterBuffer outer(2);
+  outer.get().push_arg(int64_t(1));
+  ParameterBuffer *inner_buffer;
+  {
+    ScopedParameterBuffer inner(2);
+    inner_buffer = &inner.get();
+    EXPECT_NE(inner_buffer, &outer.get());
+    EXPECT_EQ(inner.get().size(), 0);
+    inner.get().push_arg(int64_t(2));
+  }
+  EXPECT_EQ(outer.get().size(), 1);
+  // the inner one is reused, cleared
+  ScopedParameterBuffer again(2);
+  EXPECT_EQ(&again.get(), inner_buffer);
+  EXPECT_EQ(again.get().size(), 0);
+}
@@ -2,7 +2,7 @@
 
 #include "add_op.h"
 #include "c10/cuda/CUDAStream.h"
-#include "triton_jit/triton_jit_function.h"
+#include "triton_jit/torch_adapter.h"
 
 namespace my_ops {
 using namespace triton_jit;
@@ -51,7 +51,7 @@ at::Tensor add_tensor_manual_arg_handle(const at::Tensor &a_, const at::Tensor &
   ParameterBuffer buffer;
   const int num_args = 4;  // just a estimation
   buffer.reserve(num_args);
-  c10::SmallVector<std::string> signature;
+  SignatureKey signature;
   signature.reserve(num_args);
   ArgHandle handler = {f.get_static_sig(), buffer, signature, 0};
 
@@ -68,8 +68,6 @@ at::Tensor add_tensor_manual_arg_handle(const at::Tensor &a_, const at::Tensor &
   handler.handle_arg(tile_size);
   handler.append_scratch();
 
-  std::string full_signature = join_sig(signature);
-
   ensure_cuda_context();
   c10::DeviceGuard guard(out.device());
   c10::cuda::CUDAStream stream = c10::cuda::getCurrentCUDAStream();
@@ -77,10 +75,10 @@ at::Tensor add_tensor_manual_arg_handle(const at::Tensor &a_, const at::Tensor &
   CUdevice device_index;
   checkCudaErrors(cuCtxGetDevice(&device_index));
 
-  const TritonKernel &kernel = f.get_kernel(full_signature, num_warps, num_stages, device_index);
+  TritonJITFunction::ScopedKernelUse use(f);
+  const TritonKernel &kernel = f.get_kernel(signature, num_warps, num_stages, device_index);
   const unsigned int num_blocks = (n + tile_size - 1) / tile_size;
-  c10::SmallVector<void *> ptrs = buffer.get_ptrs();
-  kernel.launch(num_blocks, 1, 1, num_warps, stream, ptrs.data());
+  kernel.launch(num_blocks, 1, 1, num_warps, device_index, raw_stream, buffer.ptrs());
   return out;
 }
 
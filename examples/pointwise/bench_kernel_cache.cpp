@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "add_op.h"
+#include "c10/cuda/CUDAFunctions.h"
+#include "fmt/core.h"
+#include "torch/torch.h"
+#include "triton_jit/torch_adapter.h"
+
+using namespace triton_jit;
+
+// Measures the throughput of the hit path of TritonJITFunction::get_kernel with 1 to N threads.
+int main(int argc, char **argv) {
+  const int64_t lookups_per_thread = argc > 1 ? std::atoll(argv[1]) : 1000000;
+  const int max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  // warm up: compile the kernel via a launch
+  at::Tensor a = at::rand({128 * 1024}, at::kCUDA);
+  at::Tensor b = at::rand({128 * 1024}, at::kCUDA);
+  my_ops::add_tensor(a, b);
+  c10::cuda::device_synchronize();
+
+  const TritonJITFunction &f =
+      TritonJITFunction::get_instance(std::string("add.py"), "binary_pointwise_kernel");
+  CUdevice device_index;
+  checkCudaErrors(cuCtxGetDevice(&device_index));
+  const SignatureKey key = SignatureKey::from_signature("*fp32:16,*fp32:16,*fp32:16,i64:16,1024");
+  const TritonKernel *expected = &f.get_kernel(key, 8, 1, device_index);
+
+  fmt::print("{:>8} {:>16} {:>16}\n", "threads", "Mlookups/s", "ns/lookup");
+  for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    std::atomic<int> ready {0};
+    std::atomic<bool> start {false};
+    std::atomic<int64_t> mismatches {0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&]() {
+        ready++;
+        while (!start.load()) {
+        }
+        for (int64_t i = 0; i < lookups_per_thread; i++) {
+          if (&f.get_kernel(key, 8, 1, device_index) != expected) {
+            mismatches++;
+          }
+        }
+      });
+    }
+    while (ready.load() != num_threads) {
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    start.store(true);
+    for (std::thread &th : threads) {
+      th.join();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(t1 - t0).count();
+    double total = static_cast<double>(lookups_per_thread) * num_threads;
+    fmt::print("{:>8} {:>16.2f} {:>16.1f}\n",
+               num_threads,
+               total / seconds / 1e6,
+               seconds * 1e9 * num_threads / total);
+    if (mismatches.load() != 0) {
+      std::cerr << "get_kernel returned a different kernel" << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "add_op.h"
+#include "c10/cuda/CUDAFunctions.h"
+#include "c10/cuda/CUDAGuard.h"
+#include "c10/cuda/CUDAStream.h"
+#include "fmt/core.h"
+#include "torch/torch.h"
+#include "triton_jit/torch_adapter.h"
+
+using namespace triton_jit;
+
+namespace {
+const int NUM_THREADS = 16;
+const int NUM_ITERS = 200;
+
+template <typename F>
+void run_in_threads(int num_threads, F f) {
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back(f, t);
+  }
+  for (std::thread &th : threads) {
+    th.join();
+  }
+}
+}  // namespace
+
+TEST(concurrency_test, get_instance_returns_the_same_function) {
+  std::vector<const TritonJITFunction *> instances(NUM_THREADS, nullptr);
+  run_in_threads(NUM_THREADS, [&](int t) {
+    instances[t] = &TritonJITFunction::get_instance(std::string("add.py"), "binary_pointwise_kernel");
+  });
+  for (const TritonJITFunction *p : instances) {
+    EXPECT_EQ(p, instances[0]);
+  }
+}
+
+TEST(concurrency_test, get_kernel_returns_the_same_kernel) {
+  const TritonJITFunction &f =
+      TritonJITFunction::get_instance(std::string("add.py"), "binary_pointwise_kernel");
+  ensure_cuda_context();
+  CUdevice device_index;
+  checkCudaErrors(cuCtxGetDevice(&device_index));
+  // the same signature in binary and string forms
+  SignatureKey key = SignatureKey::from_signature("*fp32:16,*fp32:16,*fp32:16,i64:16,1024");
+  std::vector<const TritonKernel *> kernels(NUM_THREADS, nullptr);
+  run_in_threads(NUM_THREADS, [&](int t) {
+    for (int i = 0; i < NUM_ITERS; i++) {
+      const TritonKernel *k = (t % 2 == 0)
+                                  ? &f.get_kernel(key, 8, 1, device_index)
+                                  : &f.get_kernel(key.to_signature(), 8, 1, device_index);
+      if (kernels[t] == nullptr) {
+        kernels[t] = k;
+      }
+      ASSERT_EQ(kernels[t], k);
+    }
+  });
+  for (const TritonKernel *p : kernels) {
+    EXPECT_EQ(p, kernels[0]);
+  }
+}
+
+TEST(concurrency_test, distinct_keys_compile_concurrently) {
+  const TritonJITFunction &f =
+      TritonJITFunction::get_instance(std::string("add.py"), "binary_pointwise_kernel");
+  ensure_cuda_context();
+  CUdevice device_index;
+  checkCudaErrors(cuCtxGetDevice(&device_index));
+  // 4 distinct keys, each of them requested by 4 threads at once
+  std::vector<const TritonKernel *> kernels(NUM_THREADS, nullptr);
+  run_in_threads(NUM_THREADS, [&](int t) {
+    int64_t tile_size = 256 << (t % 4);
+    SignatureKey key =
+        SignatureKey::from_signature(fmt::format("*fp32:16,*fp32:16,*fp32:16,i64:16,{}", tile_size));
+    kernels[t] = &f.get_kernel(key, 4, 2, device_index);
+  });
+  for (int t = 0; t < NUM_THREADS; t++) {
+    EXPECT_EQ(kernels[t], kernels[t % 4]);
+    if (t >= 4) {
+      continue;
+    }
+    for (int u = t + 1; u < 4; u++) {
+      EXPECT_NE(kernels[t], kernels[u]);
+    }
+  }
+}
+
+TEST(concurrency_test, precompile_in_background) {
+  const TritonJITFunction &f =
+      TritonJITFunction::get_instance(std::string("add.py"), "binary_pointwise_kernel");
+  ensure_cuda_context();
+  CUdevice device_index;
+  checkCudaErrors(cuCtxGetDevice(&device_index));
+  std::vector<PrecompileRequest> requests;
+  for (int64_t tile_size : {128, 256, 512, 1024}) {
+    requests.push_back(
+        {fmt::format("*fp16:16,*fp16:16,*fp16:16,i64:16,{}", tile_size), {4, 3}, device_index});
+  }
+  std::vector<std::shared_future<const TritonKernel *>> futures = f.precompile(requests);
+  ASSERT_EQ(futures.size(), requests.size());
+  // get_kernel picks up the compiles in flight, or the compiled kernels
+  for (size_t i = 0; i < requests.size(); i++) {
+    const TritonKernel &k = f.get_kernel(requests[i].signature, 4, 3, device_index);
+    EXPECT_EQ(&k, futures[i].get());
+  }
+  // precompiling a cached kernel gives a ready future
+  std::shared_future<const TritonKernel *> again =
+      f.precompile(requests[0].signature, 4, 3, device_index);
+  EXPECT_EQ(again.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+  EXPECT_EQ(again.get(), futures[0].get());
+}
+
+TEST(concurrency_test, tiered_compilation) {
+  TritonJITFunction &f = TritonJITFunction::get_instance(std::string("add.py"), "binary_pointwise_kernel");
+  ensure_cuda_context();
+  CUdevice device_index;
+  checkCudaErrors(cuCtxGetDevice(&device_index));
+  const TritonKernel &generic = f.get_kernel("*fp32,*fp32,*fp32,i64,1024", 2, 1, device_index);
+
+  f.set_tiered_compilation(true);
+  const char *specialized_sig = "*fp32:16,*fp32:16,*fp32:16,i64:16,1024";
+  const TritonKernel &first = f.get_kernel(specialized_sig, 2, 1, device_index);
+  // the specialized kernel is compiled in the background, the generic one may serve meanwhile
+  const TritonKernel *specialized = f.precompile(specialized_sig, 2, 1, device_index).get();
+  EXPECT_TRUE(&first == &generic || &first == specialized);
+  EXPECT_NE(specialized, &generic);
+  EXPECT_EQ(&f.get_kernel(specialized_sig, 2, 1, device_index), specialized);
+  f.set_tiered_compilation(false);
+}
+
+TEST(concurrency_test, launch_from_many_threads) {
+  std::atomic<int> failures {0};
+  run_in_threads(NUM_THREADS, [&](int t) {
+    // a stream per thread, and a different size per thread to mix specializations
+    c10::cuda::CUDAStreamGuard guard(c10::cuda::getStreamFromPool());
+    int64_t n = 128 * 1024 + (t % 4);
+    at::Tensor a = at::rand({n}, at::kCUDA);
+    at::Tensor b = at::rand({n}, at::kCUDA);
+    at::Tensor expected = at::add(a, b);
+    for (int i = 0; i < NUM_ITERS; i++) {
+      at::Tensor result = my_ops::add_tensor(a, b);
+      if (!torch::allclose(result, expected)) {
+        failures++;
+      }
+    }
+  });
+  c10::cuda::device_synchronize();
+  EXPECT_EQ(failures.load(), 0);
+}
+
+TEST(concurrency_test, launches_make_the_context_of_the_stream_current) {
+  const TritonJITFunction &f =
+      TritonJITFunction::get_instance(std::string("add.py"), "binary_pointwise_kernel");
+  c10::cuda::CUDAStream stream = c10::cuda::getStreamFromPool();
+  CUstream raw_stream = static_cast<CUstream>(stream.stream());
+  int64_t n = 128 * 1024;
+  at::Tensor a = at::rand({n}, at::kCUDA);
+  at::Tensor b = at::rand({n}, at::kCUDA);
+  at::Tensor expected = at::add(a, b);
+  CUcontext stream_ctx;
+  checkCudaErrors(cuStreamGetCtx(raw_stream, &stream_ctx));
+
+  // no context, and the context of another device if any, are made current between launches on
+  // the same stream, as a device guard of another device would do
+  std::vector<CUcontext> others = {nullptr};
+  CUdevice other_device = -1;
+  if (c10::cuda::device_count() > 1) {
+    other_device = 1;
+    CUcontext other;
+    checkCudaErrors(cuDevicePrimaryCtxRetain(&other, other_device));
+    others.push_back(other);
+  }
+  for (CUcontext other : others) {
+    at::Tensor out = at::empty_like(a);
+    checkCudaErrors(cuCtxSetCurrent(stream_ctx));
+    f(raw_stream, n / 1024, 1, 1, 8, 1, a, b, out, n, int64_t(1024));
+    checkCudaErrors(cuCtxSetCurrent(other));
+    f(raw_stream, n / 1024, 1, 1, 8, 1, a, b, out, n, int64_t(1024));
+    CUcontext current;
+    checkCudaErrors(cuCtxGetCurrent(&current));
+    EXPECT_EQ(current, stream_ctx);
+    stream.synchronize();
+    EXPECT_TRUE(torch::allclose(out, expected));
+  }
+  if (other_device >= 0) {
+    checkCudaErrors(cuDevicePrimaryCtxRelease(other_device));
+  }
+}
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "triton_jit/compile_workers.h"
+
+using namespace triton_jit;
+
+namespace {
+const char *PYTHON = TRITON_JIT_PYTHON_EXECUTABLE;
+const std::string SIGNATURE = "*fp32:16,*fp32:16,*fp32:16,i64:16,1024";
+
+std::string source() {
+  return std::filesystem::absolute("add.py").string();
+}
+}  // namespace
+
+TEST(compile_workers_test, extract_static_signature) {
+  CompileWorkerPool pool(1, std::chrono::seconds(600), PYTHON);
+  std::vector<int> arg_types = pool.extract_static_signature(source(), "binary_pointwise_kernel");
+  EXPECT_EQ(arg_types, (std::vector<int> {1, 1, 1, 1, 2}));
+}
+
+TEST(compile_workers_test, compile_in_parallel) {
+  // compiling for an arch does not need a gpu in the workers
+  CompileWorkerPool pool(2, std::chrono::seconds(600), PYTHON);
+  std::vector<std::string> dirs(2);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 2; i++) {
+    threads.emplace_back([&, i]() {
+      dirs[i] = pool.compile_kernel(
+          source(), "binary_pointwise_kernel", SIGNATURE, CompileOptions(4 * (i + 1), 1), 80);
+    });
+  }
+  for (std::thread &t : threads) {
+    t.join();
+  }
+  for (const std::string &dir : dirs) {
+    EXPECT_TRUE(std::filesystem::exists(std::filesystem::path(dir) / "binary_pointwise_kernel.cubin"));
+  }
+}
+
+TEST(compile_workers_test, compiler_errors_keep_the_worker) {
+  CompileWorkerPool pool(1, std::chrono::seconds(600), PYTHON);
+  EXPECT_THROW(pool.extract_static_signature(source(), "no_such_kernel"), std::runtime_error);
+  EXPECT_EQ(pool.extract_static_signature(source(), "binary_pointwise_kernel").size(), 5);
+}
+
+TEST(compile_workers_test, timeout_restarts_the_worker) {
+  CompileWorkerPool pool(1, std::chrono::milliseconds(1), PYTHON);
+  EXPECT_THROW(pool.extract_static_signature(source(), "binary_pointwise_kernel"), CompileWorkerError);
+
+  CompileWorkerPool bad_python(1, std::chrono::seconds(600), "/nonexistent/python");
+  EXPECT_THROW(bad_python.extract_static_signature(source(), "binary_pointwise_kernel"), CompileWorkerError);
+}
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+
+#include "binary_pointwise_kernel_kernels.h"
+#include "c10/cuda/CUDAStream.h"
+#include "torch/torch.h"
+#include "triton_jit/embedded_kernels.h"
+#include "triton_jit/jit_utils.h"
+#include "triton_jit/triton_jit_function.h"
+
+// kernels of add.py compiled at build time by triton_jit_add_kernels, launched via the stubs
+using namespace triton_jit;
+
+TEST(embedded_kernels_test, stub_launches_embedded_kernel) {
+  at::Tensor a = at::rand({128 * 1024}, at::kCUDA);
+  at::Tensor b = at::rand({128 * 1024}, at::kCUDA);
+  at::Tensor out = at::empty_like(a);
+  ensure_cuda_context();
+  CUdevice device_index;
+  checkCudaErrors(cuCtxGetDevice(&device_index));
+
+  // the source is deployed here, so the embedded function is found by its hash
+  const EmbeddedFunction *embedded =
+      EmbeddedKernelRegistry::get().find_function(ADD_SOURCE, "binary_pointwise_kernel");
+  ASSERT_NE(embedded, nullptr);
+  std::string options = CompileOptions(8, 1).to_string();
+  if (!EmbeddedKernelRegistry::get().find_kernel(
+          *embedded, "*fp32:16,*fp32:16,*fp32:16,i64:16,1024", options, get_device_arch(device_index))) {
+    GTEST_SKIP() << "add.py is not embedded for the arch of the device, see TRITON_JIT_EXAMPLE_ARCHS";
+  }
+
+  int64_t n = out.numel();
+  CUstream stream = static_cast<CUstream>(c10::cuda::getCurrentCUDAStream().stream());
+  triton_jit_kernels::binary_pointwise_kernel_0(stream,
+                                                (n + 1023) / 1024,
+                                                1,
+                                                1,
+                                                reinterpret_cast<CUdeviceptr>(a.data_ptr()),
+                                                reinterpret_cast<CUdeviceptr>(b.data_ptr()),
+                                                reinterpret_cast<CUdeviceptr>(out.data_ptr()),
+                                                n);
+  EXPECT_TRUE(torch::allclose(out, a + b));
+
+  // the kernel is not compiled by the embedded interpreter
+  const TritonJITFunction &f = TritonJITFunction::get_instance(ADD_SOURCE, "binary_pointwise_kernel");
+  EXPECT_EQ(f.metrics().interpreter_time.count, 0);
+}
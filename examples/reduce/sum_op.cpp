@@ -1,7 +1,7 @@
 #include <iostream>
 #include "c10/cuda/CUDAStream.h"
 #include "torch/torch.h"
-#include "triton_jit/triton_jit_function.h"
+#include "triton_jit/torch_adapter.h"
 
 #include <filesystem>
 #include "ATen/WrapDimUtils.h"
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "cuda.h"
+
+#include "fmt/core.h"
+#include "triton_jit/triton_jit_function.h"
+
+namespace triton_jit {
+
+/**
+ * @brief A candidate config of an autotuned jit function, i.e. a triton.Config.
+ *
+ * The values of constexpr arguments are referred to by the indices of the arguments.
+ */
+struct AutotuneConfig {
+  using Value = std::variant<int64_t, double, bool>;
+  std::vector<std::pair<int, Value>> constexprs;  // sorted by index
+  int num_warps = 4;
+  int num_stages = 3;
+
+  bool operator==(const AutotuneConfig &other) const {
+    return this->constexprs == other.constexprs && this->num_warps == other.num_warps &&
+           this->num_stages == other.num_stages;
+  }
+  /* the value of the constexpr argument at the index, nullptr if the config does not set it */
+  const Value *find(int index) const;
+  std::string to_string() const;
+};
+
+/**
+ * @brief Memoizes the best config per tuning key.
+ *
+ * On the first request for a key, every config is benchmarked via the given function, which
+ * returns the time it takes; a config that throws (e.g. it runs out of resources) is skipped. The
+ * fastest one is memoized and, if a path is given, appended to it as a json line, so that later
+ * processes do not tune again. A record is identified by the id of the function and the key, and it
+ * is ignored if its config is no longer a candidate. Tuning holds a lock, so concurrent requests
+ * for a key benchmark once.
+ *
+ * It is independent of gpus, the benchmark function is where the kernels are run.
+ */
+class AutotuneCache {
+ public:
+  AutotuneCache(std::string id,
+                std::vector<AutotuneConfig> configs,
+                std::optional<std::filesystem::path> path = std::nullopt);
+
+  const AutotuneConfig &select(const std::string &key,
+                               const std::function<double(const AutotuneConfig &)> &benchmark);
+
+  const std::vector<AutotuneConfig> &configs() const {
+    return this->configs_;
+  }
+
+ private:
+  void load();
+  void append(const std::string &key, const AutotuneConfig &config);
+
+  std::string id_;
+  std::vector<AutotuneConfig> configs_;
+  std::optional<std::filesystem::path> path_;
+  std::mutex mutex_;
+  std::unordered_map<std::string, size_t> best_;  // key -> index of the config
+};
+
+/**
+ * @brief Measures a launch, returning its time in milliseconds. The default one times repeated
+ * launches on the stream with cuda events, after a warmup launch which also compiles the kernel.
+ */
+using AutotuneTimer =
+    std::function<double(CUstream stream, const AutotuneConfig &config, const std::function<void()> &launch)>;
+double cuda_event_timer(CUstream stream, const AutotuneConfig &config, const std::function<void()> &launch);
+
+/* a part of the tuning key: the dtype of a pointer, or the value of a scalar */
+template <typename T>
+std::string autotune_key_part(const T &item) {
+  using U = std::remove_cv_t<std::remove_reference_t<T>>;
+  if constexpr (is_device_ptr<U>::value) {
+    return triton_typename(item.dtype());
+  } else if constexpr (is_optional<U>::value) {
+    return item.has_value() ? autotune_key_part(item.value()) : std::string("None");
+  } else if constexpr (has_arg_adapter<U>::value) {
+    return ArgAdapter<U>::apply(item, [](const auto &v) { return autotune_key_part(v); });
+  } else if constexpr (std::is_arithmetic_v<U>) {
+    return fmt::format("{}", item);
+  } else {
+    return "?";
+  }
+}
+
+/**
+ * @brief A caching autotuner for jit functions decorated with `@triton.autotune`.
+ *
+ * It reads the configs and the key from the Autotuner in python. The call takes the arguments
+ * except those set by the configs, and a grid function of the selected config. The best config
+ * per key (the dtypes of tensors & values of scalars of the key arguments, and the cuda arch) is
+ * memoized, and persisted next to the kernel index (`autotune.jsonl`) unless the index is disabled.
+ * `pre_hook`, `reset_to_zero`, `restore_value` & `prune_configs_by` of the Autotuner are not
+ * supported.
+ */
+class TritonAutotuner {
+ public:
+  using GridFn = std::function<std::array<unsigned int, 3>(const AutotuneConfig &)>;
+
+  static TritonAutotuner &get_instance(std::string_view path, std::string_view name);
+  TritonAutotuner(const TritonAutotuner &) = delete;
+  TritonAutotuner &operator=(const TritonAutotuner &) = delete;
+
+  /* replace the timing hook, e.g. by a deterministic one in tests */
+  void set_timer(AutotuneTimer timer) {
+    std::lock_guard<std::mutex> lock(this->timer_mutex_);
+    this->timer_ = std::move(timer);
+  }
+
+  const std::vector<AutotuneConfig> &configs() const {
+    return this->cache_->configs();
+  }
+
+  template <typename... Args>
+  void operator()(CUstream stream, const GridFn &grid, Args... args);
+
+  /* launch with the given config, without tuning */
+  template <typename... Args>
+  void launch(CUstream stream, const GridFn &grid, const AutotuneConfig &config, Args... args) const;
+
+ private:
+  TritonAutotuner(std::string_view path, std::string_view name);
+
+  const TritonJITFunction &function_;
+  // whether each argument of the call is a key argument
+  std::vector<bool> is_key_;
+  std::unique_ptr<AutotuneCache> cache_;
+  AutotuneTimer timer_ = cuda_event_timer;
+  std::mutex timer_mutex_;
+
+  static std::unordered_map<std::string, std::unique_ptr<TritonAutotuner>> tuners_;
+  static std::mutex tuners_mutex_;
+};
+
+template <typename... Args>
+void TritonAutotuner::operator()(CUstream stream, const GridFn &grid, Args... args) {
+  if (sizeof...(Args) != this->is_key_.size()) {
+    throw std::invalid_argument(fmt::format("Expected {} arguments besides those set by the configs, got {}",
+                                            this->is_key_.size(),
+                                            sizeof...(Args)));
+  }
+  std::string key;
+  size_t pos = 0;
+  (
+      [&](const auto &arg) {
+        if (this->is_key_[pos++]) {
+          key += autotune_key_part(arg);
+          key += ",";
+        }
+      }(args),
+      ...);
+  // the best config depends on the gpu, too
+  Driver &driver = Driver::get();
+  key += fmt::format("sm{}", driver.device_arch(driver.stream_device(stream)));
+
+  AutotuneTimer timer;
+  {
+    std::lock_guard<std::mutex> lock(this->timer_mutex_);
+    timer = this->timer_;
+  }
+  const AutotuneConfig &config = this->cache_->select(key, [&](const AutotuneConfig &candidate) {
+    return timer(stream, candidate, [&]() { this->launch(stream, grid, candidate, args...); });
+  });
+  this->launch(stream, grid, config, args...);
+}
+
+template <typename... Args>
+void TritonAutotuner::launch(CUstream stream,
+                             const GridFn &grid,
+                             const AutotuneConfig &config,
+                             Args... args) const {
+  const StaticSignature &ssig = this->function_.get_static_sig();
+  const int num_args = ssig.num_args;
+
+  ScopedParameterBuffer scoped_buffer(num_args);
+  ParameterBuffer &buffer = scoped_buffer.get();
+  SignatureKey signature;
+  signature.reserve(num_args);
+  ArgHandle handler = {ssig, buffer, signature, 0};
+  // constexprs set by the config are interleaved with the arguments by their indices
+  auto fill_config = [&]() {
+    while (handler.idx < num_args) {
+      const AutotuneConfig::Value *value = config.find(handler.idx);
+      if (!value) {
+        break;
+      }
+      std::visit([&](auto v) { signature.push_constexpr(v); }, *value);
+      handler.idx++;
+    }
+  };
+  ((fill_config(), handler.handle_arg(args)), ...);
+  fill_config();
+  handler.append_scratch();
+
+  CUdevice device_index = Driver::get().stream_device(stream);
+  TritonJITFunction::ScopedKernelUse use(this->function_);
+  const TritonKernel &kernel =
+      this->function_.get_kernel(signature, config.num_warps, config.num_stages, device_index);
+  std::array<unsigned int, 3> g = grid(config);
+  kernel.launch(g[0], g[1], g[2], config.num_warps, device_index, stream, buffer.ptrs());
+}
+
+}  // namespace triton_jit
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace triton_jit {
+
+/**
+ * @brief Options a kernel is compiled with, i.e. the `options` of triton.compile.
+ *
+ * The options triton has for all backends are fields, backend-specific ones, e.g. `debug` or
+ * `launch_cooperative_grid` of the cuda backend, are in `backend` by their names in triton. Options
+ * unknown to the backend are ignored by triton. Kernels of different options are different
+ * kernels, see KernelKey; a field that is of its default is not passed to triton, so that the
+ * default of the backend applies.
+ *
+ * `CompileOptions(8, 1)` are the options of the num_warps & num_stages that jit functions used to
+ * take, e.g. `CompileOptions(8, 1).set("debug", false)`.
+ */
+struct CompileOptions {
+  using Value = std::variant<bool, int64_t, double, std::string>;
+
+  int num_warps = 4;
+  int num_stages = 3;
+  int num_ctas = 1;
+  int maxnreg = 0;  // max registers per thread, 0 for no limit
+  bool enable_fp_fusion = true;
+  bool launch_pdl = false;  // programmatic dependent launch, triton >= 3.4
+  std::map<std::string, Value> backend;
+
+  CompileOptions() = default;
+  CompileOptions(int num_warps, int num_stages) : num_warps(num_warps), num_stages(num_stages) {
+  }
+
+  /* set a backend-specific option, integers are stored as int64_t and strings as std::string */
+  template <typename T>
+  CompileOptions &set(const std::string &name, const T &value) {
+    if constexpr (std::is_same_v<T, bool>) {
+      this->backend[name] = value;
+    } else if constexpr (std::is_integral_v<T>) {
+      this->backend[name] = static_cast<int64_t>(value);
+    } else if constexpr (std::is_floating_point_v<T>) {
+      this->backend[name] = static_cast<double>(value);
+    } else {
+      this->backend[name] = std::string(value);
+    }
+    return *this;
+  }
+
+  /* the options passed to triton.compile, in a canonical order: num_warps, num_stages, the fields
+   * that are not of their defaults, then the backend ones by their names */
+  std::vector<std::pair<std::string, Value>> items() const;
+  /* the items as `name=value` joined by `;`, e.g. "num_warps=8;num_stages=1;debug=false". It is
+   * how options are keyed in the kernel index & embedded kernels */
+  std::string to_string() const;
+
+  bool operator==(const CompileOptions &other) const {
+    return this->num_warps == other.num_warps && this->num_stages == other.num_stages &&
+           this->num_ctas == other.num_ctas && this->maxnreg == other.maxnreg &&
+           this->enable_fp_fusion == other.enable_fp_fusion && this->launch_pdl == other.launch_pdl &&
+           this->backend == other.backend;
+  }
+  bool operator!=(const CompileOptions &other) const {
+    return !(*this == other);
+  }
+
+  /* it does not allocate, it is computed on each lookup of the kernel cache */
+  size_t hash() const {
+    uint64_t h = (static_cast<uint64_t>(this->num_warps) << 40) ^
+                 (static_cast<uint64_t>(this->num_stages) << 24) ^
+                 (static_cast<uint64_t>(this->num_ctas) << 16) ^ static_cast<uint64_t>(this->maxnreg) ^
+                 (static_cast<uint64_t>(this->enable_fp_fusion) << 62) ^
+                 (static_cast<uint64_t>(this->launch_pdl) << 63);
+    for (const auto &[name, value] : this->backend) {
+      h = h * 31 + std::hash<std::string>()(name);
+      h = h * 31 + std::hash<Value>()(value);
+    }
+    return h;
+  }
+};
+
+}  // namespace triton_jit
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <sys/types.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "triton_jit/compile_options.h"
+
+namespace triton_jit {
+
+/* a compile worker crashed, timed out or cannot be spawned, unlike errors of the compiler itself */
+class CompileWorkerError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief A pool of compile worker processes.
+ *
+ * Compiling in the embedded interpreter holds the GIL, so at most one compile runs at a time, and
+ * it loads torch & triton into the process. The pool compiles in worker processes that run
+ * `scripts/compile_worker.py` instead. Each worker is connected via a unix socket pair and serves
+ * one request at a time, so up to `num_workers` compiles run in parallel.
+ *
+ * Workers are spawned lazily, a worker that crashes or exceeds the timeout is killed and respawned
+ * for the next request, while the failed request throws CompileWorkerError. Errors reported by the
+ * compiler throw std::runtime_error.
+ *
+ * The process-wide pool is configured by environment variables: `TRITON_JIT_COMPILE_WORKERS`, the
+ * number of workers, 0 (default) disables the pool, so compiles stay in the embedded interpreter;
+ * `TRITON_JIT_COMPILE_TIMEOUT`, timeout of a request in seconds, 600 by default;
+ * `TRITON_JIT_PYTHON`, the python interpreter of the workers, the one found at build time by
+ * default.
+ */
+class CompileWorkerPool {
+ public:
+  CompileWorkerPool(int num_workers, std::chrono::milliseconds timeout, std::string python_executable);
+  ~CompileWorkerPool();
+  CompileWorkerPool(const CompileWorkerPool &) = delete;
+  CompileWorkerPool &operator=(const CompileWorkerPool &) = delete;
+
+  /* the process-wide pool, nullptr if it is disabled */
+  static CompileWorkerPool *get();
+
+  /* static signature of a jit function, see gen_ssig.py */
+  std::vector<int> extract_static_signature(const std::string &file, const std::string &function);
+  /* configs & key of an autotuned function in json, see compiler_session.py */
+  std::string extract_autotune_configs(const std::string &file, const std::string &function);
+  /* compile a kernel for the arch, returns the directory of the compiled kernel */
+  std::string compile_kernel(const std::string &file,
+                             const std::string &function,
+                             const std::string &signature,
+                             const CompileOptions &options,
+                             unsigned int arch);
+
+  int num_workers() const {
+    return static_cast<int>(this->workers_.size());
+  }
+
+ private:
+  struct Worker {
+    pid_t pid = -1;
+    int fd = -1;
+    bool busy = false;
+  };
+
+  /* send a request line to an idle worker and wait for the response line */
+  std::string request(const std::string &line);
+  void spawn(Worker &worker);
+  void kill(Worker &worker);
+  /* read a line from the worker before the deadline, returns false on timeout or eof */
+  bool read_line(Worker &worker, std::chrono::steady_clock::time_point deadline, std::string &line);
+
+  std::chrono::milliseconds timeout_;
+  std::string python_executable_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<Worker> workers_;
+};
+
+}  // namespace triton_jit
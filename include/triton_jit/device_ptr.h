@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "triton_jit/signature_key.h"
+
+namespace triton_jit {
+
+/* storage types of 16-bit floats, for DevicePtr<float16> and DevicePtr<bfloat16>. The runtime
+ * never reads the elements, so they are only tags */
+struct float16 {
+  uint16_t bits;
+};
+struct bfloat16 {
+  uint16_t bits;
+};
+
+/* the triton data type of elements of type T in device memory */
+template <typename T>
+struct element_type;
+
+#define DEFINE_ELEMENT_TYPE(T, Type)                     \
+  template <>                                            \
+  struct element_type<T> {                               \
+    static constexpr TritonType type = TritonType::Type; \
+  }
+
+DEFINE_ELEMENT_TYPE(bool, I1);
+DEFINE_ELEMENT_TYPE(int8_t, I8);
+DEFINE_ELEMENT_TYPE(int16_t, I16);
+DEFINE_ELEMENT_TYPE(int32_t, I32);
+DEFINE_ELEMENT_TYPE(int64_t, I64);
+DEFINE_ELEMENT_TYPE(uint8_t, U8);
+DEFINE_ELEMENT_TYPE(uint16_t, U16);
+DEFINE_ELEMENT_TYPE(uint32_t, U32);
+DEFINE_ELEMENT_TYPE(uint64_t, U64);
+DEFINE_ELEMENT_TYPE(float16, FP16);
+DEFINE_ELEMENT_TYPE(bfloat16, BF16);
+DEFINE_ELEMENT_TYPE(float, FP32);
+DEFINE_ELEMENT_TYPE(double, FP64);
+
+#undef DEFINE_ELEMENT_TYPE
+
+/**
+ * @brief An address in device memory with the data type of its elements, which is how jit
+ * functions take tensors without depending on a framework, e.g.
+ * `f(stream, grid_x, 1, 1, 4, 1, DevicePtr<float>(x), DevicePtr<float>(out), n)`.
+ *
+ * DevicePtr<T> gets the data type from T, see element_type. DevicePtr<void> carries it at runtime,
+ * for memory whose data type is only known at runtime; typed pointers convert to it.
+ */
+template <typename T>
+class DevicePtr {
+ public:
+  constexpr explicit DevicePtr(T *ptr) : ptr_(ptr) {
+  }
+  constexpr T *get() const {
+    return this->ptr_;
+  }
+  static constexpr TritonType dtype() {
+    return element_type<std::remove_cv_t<T>>::type;
+  }
+
+ private:
+  T *ptr_;
+};
+
+template <>
+class DevicePtr<void> {
+ public:
+  constexpr DevicePtr(void *ptr, TritonType dtype) : ptr_(ptr), dtype_(dtype) {
+  }
+  template <typename T>
+  constexpr DevicePtr(DevicePtr<T> ptr)
+      : ptr_(const_cast<std::remove_cv_t<T> *>(ptr.get())), dtype_(ptr.dtype()) {
+  }
+  constexpr void *get() const {
+    return this->ptr_;
+  }
+  constexpr TritonType dtype() const {
+    return this->dtype_;
+  }
+
+ private:
+  void *ptr_;
+  TritonType dtype_;
+};
+
+template <typename T>
+struct is_device_ptr_helper : public std::false_type {};
+
+template <typename T>
+struct is_device_ptr_helper<DevicePtr<T>> : public std::true_type {};
+
+template <typename T>
+struct is_device_ptr : public is_device_ptr_helper<std::remove_cv_t<std::remove_reference_t<T>>> {};
+
+/**
+ * @brief A customization point to pass arguments of other types to jit functions, e.g. the tensors
+ * and scalars of a framework, see triton_jit/torch_adapter.h. A specialization for T defines
+ *
+ *   static constexpr bool is_pointer;  // whether items convert to DevicePtrs
+ *   template <typename F>
+ *   static auto apply(const T &item, F &&f);  // returns f(converted item)
+ *
+ * where the item is converted to what jit functions take: a DevicePtr, an arithmetic scalar or
+ * std::nullopt. It has to be visible wherever arguments of type T are passed.
+ */
+template <typename T, typename Enable = void>
+struct ArgAdapter;
+
+template <typename T, typename = void>
+struct has_arg_adapter : public std::false_type {};
+
+// an adapter is specialized iff it is a complete type
+template <typename T>
+struct has_arg_adapter<T, std::void_t<decltype(sizeof(ArgAdapter<T>))>> : public std::true_type {};
+
+}  // namespace triton_jit
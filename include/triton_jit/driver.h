@@ -0,0 +1,259 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cuda.h"
+#include "triton_jit/launch_attributes.h"
+
+namespace triton_jit {
+
+/**
+ * @brief The driver APIs used by the runtime to load & launch kernels.
+ *
+ * The default one is CudaDriver, which calls the CUDA driver API. Replacing it, via Driver::set or
+ * `TRITON_JIT_DRIVER=null`, makes it possible to run the host side of launches on machines
+ * without gpus, e.g. to measure the host overhead. The driver should be set before any kernel is
+ * loaded, since loaded kernels keep the handles of the driver that loaded them.
+ */
+class Driver {
+ public:
+  virtual ~Driver() = default;
+
+  /* the device of the current context, making the primary context of device 0 current if there
+   * is none */
+  virtual CUdevice current_device() = 0;
+  /* make the context of the stream current and return its device, a null stream is in the
+   * current context. Launches get their device via it */
+  virtual CUdevice stream_device(CUstream stream) = 0;
+  /* compute capability of a device, e.g. 80 for sm_80 */
+  virtual unsigned int device_arch(CUdevice device) = 0;
+  /* load a cubin image into the current context, which is of the device */
+  virtual CUmodule load_module(CUdevice device, const void *image) = 0;
+  /* unload a module loaded by load_module, e.g. when its kernels are evicted from the cache */
+  virtual void unload_module(CUdevice device, CUmodule module) = 0;
+  /* get the kernel in a loaded module, which needs `shared` bytes of shared memory */
+  virtual CUfunction get_function(CUdevice device,
+                                  CUmodule module,
+                                  const std::string &kernel_name,
+                                  unsigned int shared) = 0;
+  virtual void launch(CUfunction function,
+                      unsigned int grid_x,
+                      unsigned int grid_y,
+                      unsigned int grid_z,
+                      unsigned int block_x,
+                      unsigned int shared,
+                      CUstream stream,
+                      void **args) = 0;
+  /* launch with the arguments packed in the kernel parameter layout */
+  virtual void launch_packed(CUfunction function,
+                             unsigned int grid_x,
+                             unsigned int grid_y,
+                             unsigned int grid_z,
+                             unsigned int block_x,
+                             unsigned int shared,
+                             CUstream stream,
+                             void *params,
+                             size_t params_size) = 0;
+  /* launch via cuLaunchKernelEx with the attributes, the grid is in programs, see
+   * LaunchAttributes::grid_dims. The arguments are passed by pointers, or packed if args is
+   * nullptr */
+  virtual void launch_with_attributes(CUfunction function,
+                                      unsigned int grid_x,
+                                      unsigned int grid_y,
+                                      unsigned int grid_z,
+                                      unsigned int block_x,
+                                      unsigned int shared,
+                                      CUstream stream,
+                                      void **args,
+                                      void *params,
+                                      size_t params_size,
+                                      const LaunchAttributes &attributes) = 0;
+
+  /* the active driver */
+  static Driver &get() {
+    Driver *driver = active_.load(std::memory_order_acquire);
+    return driver ? *driver : default_driver();
+  }
+  /* replace the active driver, which is not owned; nullptr restores the default one */
+  static void set(Driver *driver) {
+    active_.store(driver, std::memory_order_release);
+  }
+
+ private:
+  static Driver &default_driver();
+  static std::atomic<Driver *> active_;
+};
+
+/**
+ * @brief The CUDA driver API.
+ *
+ * The context & device of launches are cached per thread, so a launch on a stream of the same
+ * context as the previous launch on the thread costs cuStreamGetCtx & cuCtxGetCurrent only.
+ */
+class CudaDriver : public Driver {
+ public:
+  CUdevice current_device() override;
+  CUdevice stream_device(CUstream stream) override;
+  unsigned int device_arch(CUdevice device) override;
+  CUmodule load_module(CUdevice device, const void *image) override;
+  void unload_module(CUdevice device, CUmodule module) override;
+  CUfunction get_function(CUdevice device,
+                          CUmodule module,
+                          const std::string &kernel_name,
+                          unsigned int shared) override;
+  void launch(CUfunction function,
+              unsigned int grid_x,
+              unsigned int grid_y,
+              unsigned int grid_z,
+              unsigned int block_x,
+              unsigned int shared,
+              CUstream stream,
+              void **args) override;
+  void launch_packed(CUfunction function,
+                     unsigned int grid_x,
+                     unsigned int grid_y,
+                     unsigned int grid_z,
+                     unsigned int block_x,
+                     unsigned int shared,
+                     CUstream stream,
+                     void *params,
+                     size_t params_size) override;
+  void launch_with_attributes(CUfunction function,
+                              unsigned int grid_x,
+                              unsigned int grid_y,
+                              unsigned int grid_z,
+                              unsigned int block_x,
+                              unsigned int shared,
+                              CUstream stream,
+                              void **args,
+                              void *params,
+                              size_t params_size,
+                              const LaunchAttributes &attributes) override;
+
+ private:
+  static constexpr int MAX_CACHED_DEVICES = 64;
+  // arch of each device, 0 if it is not queried yet
+  std::array<std::atomic<unsigned int>, MAX_CACHED_DEVICES> archs_ {};
+  // the context each module is loaded into, it is made current to unload the module
+  std::mutex modules_mutex_;
+  std::unordered_map<CUmodule, CUcontext> module_contexts_;
+};
+
+/**
+ * @brief A driver without a gpu. Modules are "loaded" without reading the cubins, and launches
+ * are counted, or recorded if recording is enabled, instead of executed. All devices are of the
+ * given arch, and launches go to the device set by set_device regardless of their streams.
+ */
+class NullDriver : public Driver {
+ public:
+  struct LaunchRecord {
+    std::string kernel_name;
+    std::array<unsigned int, 3> grid;
+    unsigned int block_x;
+    unsigned int shared;
+    CUstream stream;
+    size_t params_size;  // size of the packed arguments, 0 if they are passed by pointers
+    LaunchAttributes attributes;
+  };
+
+  explicit NullDriver(unsigned int arch = 80) : arch_(arch) {
+  }
+  ~NullDriver() override;
+
+  CUdevice current_device() override {
+    return this->device_.load(std::memory_order_relaxed);
+  }
+  CUdevice stream_device(CUstream stream) override {
+    return this->device_.load(std::memory_order_relaxed);
+  }
+  unsigned int device_arch(CUdevice device) override {
+    return this->arch_;
+  }
+  CUmodule load_module(CUdevice device, const void *image) override;
+  void unload_module(CUdevice device, CUmodule module) override {
+    this->num_unloads_.fetch_add(1, std::memory_order_relaxed);
+  }
+  CUfunction get_function(CUdevice device,
+                          CUmodule module,
+                          const std::string &kernel_name,
+                          unsigned int shared) override;
+  void launch(CUfunction function,
+              unsigned int grid_x,
+              unsigned int grid_y,
+              unsigned int grid_z,
+              unsigned int block_x,
+              unsigned int shared,
+              CUstream stream,
+              void **args) override;
+  void launch_packed(CUfunction function,
+                     unsigned int grid_x,
+                     unsigned int grid_y,
+                     unsigned int grid_z,
+                     unsigned int block_x,
+                     unsigned int shared,
+                     CUstream stream,
+                     void *params,
+                     size_t params_size) override;
+  void launch_with_attributes(CUfunction function,
+                              unsigned int grid_x,
+                              unsigned int grid_y,
+                              unsigned int grid_z,
+                              unsigned int block_x,
+                              unsigned int shared,
+                              CUstream stream,
+                              void **args,
+                              void *params,
+                              size_t params_size,
+                              const LaunchAttributes &attributes) override;
+
+  /* the device of launches, 0 by default */
+  void set_device(CUdevice device) {
+    this->device_.store(device, std::memory_order_relaxed);
+  }
+  /* keep a record of each launch, which costs an allocation per launch */
+  void set_recording(bool enabled) {
+    this->recording_.store(enabled, std::memory_order_relaxed);
+  }
+  uint64_t num_launches() const {
+    return this->num_launches_.load(std::memory_order_relaxed);
+  }
+  /* number of modules loaded */
+  uint64_t num_loads() const {
+    return this->num_loads_.load(std::memory_order_relaxed);
+  }
+  /* number of modules unloaded */
+  uint64_t num_unloads() const {
+    return this->num_unloads_.load(std::memory_order_relaxed);
+  }
+  std::vector<LaunchRecord> launches() const;
+  void clear();
+
+ private:
+  void record(CUfunction function,
+              std::array<unsigned int, 3> grid,
+              unsigned int block_x,
+              unsigned int shared,
+              CUstream stream,
+              size_t params_size,
+              const LaunchAttributes &attributes = LaunchAttributes());
+
+  unsigned int arch_;
+  std::atomic<CUdevice> device_ {0};
+  std::atomic<bool> recording_ {false};
+  std::atomic<uint64_t> num_launches_ {0};
+  std::atomic<uint64_t> num_loads_ {0};
+  std::atomic<uint64_t> num_unloads_ {0};
+  mutable std::mutex mutex_;
+  std::vector<LaunchRecord> launches_;
+  // names of the loaded kernels, a function handle points to one of them
+  std::vector<std::unique_ptr<std::string>> functions_;
+};
+
+}  // namespace triton_jit
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace triton_jit {
+
+/**
+ * @brief Static signature of a jit function embedded at build time.
+ *
+ * Instances are emitted by `scripts/embed_kernels.py`, which is driven by the cmake function
+ * `triton_jit_add_kernels`. The arrays they point to have static storage duration.
+ */
+struct EmbeddedFunction {
+  const char *file;  // file name of the python source, without directories
+  const char *function;
+  uint64_t source_hash;  // KernelIndex::hash_file of the source it is compiled from
+  const int *arg_types;  // values of ArgType
+  int num_args;
+};
+
+/**
+ * @brief A kernel compiled at build time, with its cubin and metadata embedded in the binary.
+ */
+struct EmbeddedKernel {
+  const char *file;  // file name of the python source, without directories
+  const char *function;
+  uint64_t source_hash;
+  const char *signature;  // full signature in its string form
+  int num_warps;
+  int num_stages;
+  unsigned int arch;
+  const unsigned char *cubin;
+  size_t cubin_size;
+  const char *metadata;  // content of the json metadata file
+};
+
+/**
+ * @brief A process-wide registry of embedded kernels.
+ *
+ * Generated sources register their kernels during static initialization. TritonJITFunction
+ * resolves static signatures and kernels here first, so embedded ones never reach the
+ * embedded python interpreter. Functions are matched by the file name of the source, since the
+ * directory it is in differs between the build and the deployment, and by the hash of the source
+ * if it is present, so sources of the same name in different directories do not collide, and an
+ * edited source is not served by kernels compiled from an earlier version of it.
+ */
+class EmbeddedKernelRegistry {
+ public:
+  static EmbeddedKernelRegistry &get();
+
+  void add_function(const EmbeddedFunction &function);
+  void add_kernel(const EmbeddedKernel &kernel);
+
+  /* path is where the source is at runtime. If it is not deployed, its hash is not checked, and a
+   * function is only found if a single one of that file name is embedded */
+  const EmbeddedFunction *find_function(std::string_view path, std::string_view function) const;
+  /* kernels of a function found by find_function. Options are in the form of
+   * CompileOptions::to_string, embedded kernels are compiled with the default options besides
+   * num_warps & num_stages */
+  const EmbeddedKernel *find_kernel(const EmbeddedFunction &function,
+                                    std::string_view signature,
+                                    std::string_view options,
+                                    unsigned int arch) const;
+
+ private:
+  EmbeddedKernelRegistry() = default;
+
+  mutable std::mutex mutex_;
+  // functions of the same file name & function name, compiled from different sources
+  std::unordered_map<std::string, std::vector<const EmbeddedFunction *>> functions_;
+  std::unordered_map<std::string, const EmbeddedKernel *> kernels_;
+};
+
+}  // namespace triton_jit
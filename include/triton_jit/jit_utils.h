@@ -1,68 +1,23 @@
 #pragma once
 
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <filesystem>
 #include <mutex>
 #include <optional>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <vector>
 
-#include "c10/util/Logging.h"  // use torch's logging
 #include "cuda.h"
-#include "torch/torch.h"
+#include "triton_jit/logging.h"
+#include "triton_jit/signature_key.h"
 
 namespace triton_jit {
 
-constexpr const char *to_triton_typename(c10::ScalarType t) {
-  switch (t) {
-    case c10::ScalarType::Float:
-      return "fp32";
-    case c10::ScalarType::Double:
-      return "fp64";
-    case c10::ScalarType::Half:
-      return "fp16";
-    case c10::ScalarType::BFloat16:
-      return "bf16";
-    case c10::ScalarType::Int:
-      return "i32";
-    case c10::ScalarType::Long:
-      return "i64";
-    case c10::ScalarType::Short:
-      return "i16";
-    case c10::ScalarType::UInt32:
-      return "u32";
-    case c10::ScalarType::UInt64:
-      return "u64";
-    case c10::ScalarType::UInt16:
-      return "u16";
-    case c10::ScalarType::Char:
-      return "i8";
-    case c10::ScalarType::Byte:
-      return "u8";
-    case c10::ScalarType::Bool:
-      return "i1";
-    default:
-      throw std::runtime_error("<unsupported_type>");
-      return "<unsupported_type>";
-  }
-}
-
-template <typename T>
-constexpr const char *spec(T v) {
-  return v % 16 == 0 ? ":16" : v == 1 ? ":1" : "";
-}
-
-template <typename T, typename = void>
-struct has_data_ptr : std::false_type {};
-
-template <typename T>
-struct has_data_ptr<
-    T,
-    std::enable_if_t<std::conjunction_v<
-        std::is_same<decltype(std::declval<std::remove_reference_t<T>>().data_ptr()), void *>,
-        std::is_same<decltype(std::declval<std::remove_reference_t<T>>().scalar_type()), c10::ScalarType>>>>
-    : std::true_type {};
-
 template <typename T>
 struct is_optional_helper : public std::false_type {};
 
@@ -72,15 +27,6 @@ struct is_optional_helper<std::optional<T>> : public std::true_type {};
 template <typename T>
 struct is_optional : public is_optional_helper<std::remove_const_t<std::remove_reference_t<T>>> {};
 
-template <typename T>
-struct is_scalar_helper : public std::false_type {};
-
-template <>
-struct is_scalar_helper<c10::Scalar> : public std::true_type {};
-
-template <typename T>
-struct is_scalar : public is_scalar_helper<std::remove_const_t<std::remove_reference_t<T>>> {};
-
 template <typename T>
 struct triton_type_helper;
 
@@ -88,33 +34,67 @@ template <typename T, typename U>
 struct is_same_ignore_cvref : public std::is_same<std::remove_reference_t<std::remove_cv_t<T>>,
                                                   std::remove_reference_t<std::remove_cv_t<U>>> {};
 
-#define DEFINE_TRITON_TYPE(T, Name)           \
-  template <>                                 \
-  struct triton_type_helper<T> {              \
-    static constexpr const char *name = Name; \
+#define DEFINE_TRITON_TYPE(T, Name, Type, IsPointer)     \
+  template <>                                            \
+  struct triton_type_helper<T> {                         \
+    static constexpr const char *name = Name;            \
+    static constexpr TritonType type = TritonType::Type; \
+    static constexpr bool is_pointer = IsPointer;        \
   }
 
-DEFINE_TRITON_TYPE(bool, "i1");
-DEFINE_TRITON_TYPE(int, "i32");
-DEFINE_TRITON_TYPE(uint, "u32");
-DEFINE_TRITON_TYPE(int64_t, "i64");
-DEFINE_TRITON_TYPE(uint64_t, "u64");
-DEFINE_TRITON_TYPE(float, "fp32");
-DEFINE_TRITON_TYPE(double, "fp64");
-DEFINE_TRITON_TYPE(std::nullptr_t, "*i8");
+DEFINE_TRITON_TYPE(bool, "i1", I1, false);
+DEFINE_TRITON_TYPE(int, "i32", I32, false);
+DEFINE_TRITON_TYPE(unsigned int, "u32", U32, false);
+DEFINE_TRITON_TYPE(int64_t, "i64", I64, false);
+DEFINE_TRITON_TYPE(uint64_t, "u64", U64, false);
+DEFINE_TRITON_TYPE(float, "fp32", FP32, false);
+DEFINE_TRITON_TYPE(double, "fp64", FP64, false);
+DEFINE_TRITON_TYPE(std::nullptr_t, "*i8", I8, true);
 
 #undef DEFINE_TRITON_TYPE
 
 template <typename T>
 struct triton_type : triton_type_helper<std::remove_cv_t<std::remove_reference_t<T>>> {};
 
+// pointers to scratch memory appended to the arguments of each launch, as triton's launcher does
+#ifdef TRITON_GE_3P5
+constexpr int NUM_SCRATCH_ARGS = 2;  // global & profile scratch
+#else
+constexpr int NUM_SCRATCH_ARGS = 1;  // global scratch
+#endif
+// the version of triton the library is built for, "unknown" if triton is not found at build time
+const char *get_triton_version();
+
 // path of python executable
 std::filesystem::path get_script_dir();
 const char *get_gen_static_sig_script();
 const char *get_standalone_compile_script();
+std::filesystem::path get_home_directory();
+/* make the primary context of device 0 current if no context is current */
 void ensure_cuda_context();
-
-#define checkCudaErrors(err) __checkCudaErrors(err, __FILE__, __LINE__)
+// compute capability of a device, e.g. 80 for sm_80
+unsigned int get_device_arch(CUdevice device_index);
+
+// whether logging on the hot path, e.g. of each launch, is on. It is set by TRITON_JIT_VERBOSE=1
+extern const bool verbose_logging;
+
+// logging on the hot path, which costs one branch when verbose_logging is off. It is logged at INFO
+// regardless of TRITON_JIT_LOG_LEVEL, and compiled out by building with TRITON_JIT_NO_VERBOSE_LOG
+#define TRITON_JIT_VLOG_MESSAGE \
+  ::triton_jit::LogMessage(::triton_jit::LogLevel::INFO, __FILE__, __LINE__).stream()
+#ifdef TRITON_JIT_NO_VERBOSE_LOG
+#define TRITON_JIT_VLOG \
+  if (true) {           \
+  } else                \
+    TRITON_JIT_VLOG_MESSAGE
+#else
+#define TRITON_JIT_VLOG                 \
+  if (!::triton_jit::verbose_logging) { \
+  } else                                \
+    TRITON_JIT_VLOG_MESSAGE
+#endif
+
+#define checkCudaErrors(err) ::triton_jit::__checkCudaErrors(err, __FILE__, __LINE__)
 
 // Error handling function using exceptions instead of exit()
 inline void __checkCudaErrors(CUresult code, const char *file, const int line) {
@@ -131,7 +111,7 @@ inline void __checkCudaErrors(CUresult code, const char *file, const int line) {
   }
 }
 
-inline std::string join_sig(const c10::SmallVector<std::string> &signature) {
+inline std::string join_sig(const std::vector<std::string> &signature) {
   std::stringstream ss;
   for (size_t i = 0; i < signature.size(); i++) {
     if (i == 0) {
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace triton_jit {
+
+/**
+ * @brief A persistent index from kernel specifications to the artifacts compiled for them.
+ *
+ * Triton's cache keeps the compiled kernels across processes, but finding one requires running
+ * the compiler in the embedded interpreter. This index records, for each compiled kernel, the
+ * cache directory that TritonKernel needs, keyed by the source file, function name, hash of the
+ * source, full signature, compile options and cuda arch, and by the version of triton that compiled
+ * it and the number of scratch arguments, so kernels of a triton the library is not built for are
+ * never loaded. It also records static signatures, so that a warm restart does not need python at
+ * all.
+ *
+ * The index is an append-only file of json lines at `$TRITON_JIT_CACHE_DIR/index.jsonl`
+ * (`~/.triton/libtriton_jit/index.jsonl` by default), later lines override earlier ones. Setting
+ * `TRITON_JIT_DISABLE_INDEX=1` disables it. Note that the hash only covers the file that defines
+ * the jit function, not the modules it imports.
+ */
+class KernelIndex {
+ public:
+  /* the process-wide index, loaded on first use */
+  static KernelIndex &get();
+
+  bool enabled() const {
+    return this->enabled_;
+  }
+  /* the directory of the index, where other persistent caches live, too */
+  std::filesystem::path directory() const {
+    return this->path_.parent_path();
+  }
+
+  std::optional<std::vector<int>> find_static_signature(const std::string &file,
+                                                        const std::string &function,
+                                                        uint64_t source_hash);
+  void add_static_signature(const std::string &file,
+                            const std::string &function,
+                            uint64_t source_hash,
+                            const std::vector<int> &arg_types);
+
+  /* returns the kernel directory only if it still holds the kernel's metadata & cubin, and the
+   * kernel is compiled by the version of triton the library is built for */
+  std::optional<std::string> find_kernel_dir(const std::string &file,
+                                             const std::string &function,
+                                             uint64_t source_hash,
+                                             const std::string &signature,
+                                             const std::string &options,
+                                             unsigned int arch);
+  /* kernels compiled by another version of triton, as recorded in their metadata, are skipped */
+  void add_kernel_dir(const std::string &file,
+                      const std::string &function,
+                      uint64_t source_hash,
+                      const std::string &signature,
+                      const std::string &options,
+                      unsigned int arch,
+                      const std::string &dir);
+
+  /* a stable (FNV-1a) hash of a file's content */
+  static uint64_t hash_file(const std::filesystem::path &path);
+
+ private:
+  KernelIndex();
+  void load();
+  void append(const std::string &line);
+
+  bool enabled_ = true;
+  std::filesystem::path path_;
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::vector<int>> static_signatures_;
+  std::unordered_map<std::string, std::string> kernel_dirs_;
+};
+
+}  // namespace triton_jit
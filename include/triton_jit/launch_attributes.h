@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include "cuda.h"
+
+namespace triton_jit {
+
+/**
+ * @brief How a kernel is launched besides its grid, from the metadata triton compiles it with:
+ * thread block clusters (`num_ctas`, or `cluster_dims` of older versions), a cooperative grid
+ * (`launch_cooperative_grid`) and programmatic dependent launch (`launch_pdl`).
+ *
+ * A kernel without any of them is launched via cuLaunchKernel, others via cuLaunchKernelEx with
+ * the attributes from `fill`, as the launcher of triton does.
+ */
+struct LaunchAttributes {
+  // cluster dimension, cluster scheduling policy, cooperative, programmatic stream serialization
+  static constexpr size_t MAX_ATTRIBUTES = 4;
+
+  // the shape of a cluster in blocks, {num_ctas, 1, 1} unless cluster_dims is in the metadata
+  std::array<unsigned int, 3> cluster_dims {1, 1, 1};
+  bool cooperative = false;
+  bool pdl = false;
+
+  /* parse the json metadata of a kernel, keys that are missing are of their defaults */
+  static LaunchAttributes from_metadata(std::string_view metadata);
+
+  unsigned int cluster_size() const {
+    return this->cluster_dims[0] * this->cluster_dims[1] * this->cluster_dims[2];
+  }
+  /* whether it is launched via cuLaunchKernel */
+  bool plain() const {
+    return this->cluster_size() == 1 && !this->cooperative && !this->pdl;
+  }
+  /* the grid in blocks of a launch whose grid is in programs, each of which is a cluster */
+  std::array<unsigned int, 3> grid_dims(unsigned int grid_x, unsigned int grid_y, unsigned int grid_z) const {
+    return {grid_x * this->cluster_dims[0], grid_y * this->cluster_dims[1], grid_z * this->cluster_dims[2]};
+  }
+  /* write the attributes of cuLaunchKernelEx to attrs, which holds MAX_ATTRIBUTES, and return how
+   * many there are */
+  size_t fill(CUlaunchAttribute *attrs) const;
+};
+
+}  // namespace triton_jit
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <sstream>
+
+namespace triton_jit {
+
+enum struct LogLevel : int {
+  INFO = 0,
+  WARNING = 1,
+  ERROR = 2,
+};
+
+/* messages below it are dropped. It is set by TRITON_JIT_LOG_LEVEL=INFO|WARNING|ERROR, WARNING by
+ * default, as torch's logging */
+LogLevel min_log_level();
+
+/**
+ * @brief A line of the log, written to stderr as a whole when it is destroyed, so that lines of
+ * concurrent threads do not interleave. It does not depend on torch's logging, so that the library
+ * does not depend on libtorch.
+ */
+class LogMessage {
+ public:
+  LogMessage(LogLevel level, const char *file, int line);
+  ~LogMessage();
+  LogMessage(const LogMessage &) = delete;
+  LogMessage &operator=(const LogMessage &) = delete;
+
+  std::ostream &stream() {
+    return this->stream_;
+  }
+
+ private:
+  std::ostringstream stream_;
+};
+
+}  // namespace triton_jit
+
+// e.g. TRITON_JIT_LOG(WARNING) << "message"; the message is not formatted if it is dropped
+#define TRITON_JIT_LOG(severity)                                                            \
+  if (::triton_jit::LogLevel::severity < ::triton_jit::min_log_level()) {                   \
+  } else                                                                                    \
+    ::triton_jit::LogMessage(::triton_jit::LogLevel::severity, __FILE__, __LINE__).stream()
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "triton_jit/sharded_mutex.h"
+
+namespace triton_jit {
+
+/**
+ * @brief A monotonic counter for hot paths. Each thread adds to its own shard, so that threads
+ * launching concurrently do not contend on a cache line; a read sums the shards.
+ */
+class Counter {
+ public:
+  static constexpr size_t NUM_SHARDS = 16;
+
+  Counter() = default;
+  Counter(const Counter &) = delete;
+  Counter &operator=(const Counter &) = delete;
+
+  void add(uint64_t n = 1) {
+    this->shards_[thread_shard_index() % NUM_SHARDS].value.fetch_add(n, std::memory_order_relaxed);
+  }
+  uint64_t value() const {
+    uint64_t sum = 0;
+    for (const Shard &s : this->shards_) {
+      sum += s.value.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> value {0};
+  };
+  std::array<Shard, NUM_SHARDS> shards_;
+};
+
+/**
+ * @brief The counts of a Histogram at a point in time. counts[i] is the number of observations in
+ * (bounds[i - 1], bounds[i]], the last count is of those above the last bound.
+ */
+struct HistogramSnapshot {
+  std::vector<double> bounds;  // in seconds
+  std::vector<uint64_t> counts;
+  uint64_t count = 0;
+  double sum = 0;  // in seconds
+};
+
+/**
+ * @brief A histogram of durations with fixed buckets, from 100us to 5min. It is meant for slow
+ * paths (compiles, module loads), each observation is a few relaxed atomic adds.
+ */
+class Histogram {
+ public:
+  static constexpr std::array<double, 14> BOUNDS = {
+      1e-4, 5e-4, 1e-3, 5e-3, 1e-2, 5e-2, 0.1, 0.5, 1, 5, 10, 30, 60, 300};
+
+  Histogram() = default;
+  Histogram(const Histogram &) = delete;
+  Histogram &operator=(const Histogram &) = delete;
+
+  void observe(std::chrono::nanoseconds duration);
+  HistogramSnapshot snapshot() const;
+
+ private:
+  std::array<std::atomic<uint64_t>, BOUNDS.size() + 1> counts_ {};
+  std::atomic<uint64_t> sum_ns_ {0};
+};
+
+/**
+ * @brief Observes the time from its construction to its destruction, on success or not.
+ */
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(Histogram &histogram)
+      : histogram_(histogram), start_(std::chrono::steady_clock::now()) {
+  }
+  ~ScopedTimer() {
+    this->histogram_.observe(std::chrono::steady_clock::now() - this->start_);
+  }
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+ private:
+  Histogram &histogram_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/* metrics of a compiled kernel */
+struct KernelMetrics {
+  std::string signature;
+  int num_warps;
+  int num_stages;
+  std::string options;  // all compile options, see CompileOptions::to_string
+  unsigned int arch;
+  uint64_t launches;
+  HistogramSnapshot module_load_time;  // one observation per device the kernel is loaded into
+};
+
+/* metrics of a TritonJITFunction and its kernels */
+struct FunctionMetrics {
+  std::string file;
+  std::string function;
+  uint64_t cache_hits;
+  uint64_t cache_misses;
+  uint64_t evictions;  // kernels evicted from the cache, see TritonJITFunction::set_max_kernels
+  size_t num_signatures;  // distinct signatures among the cached kernels
+  HistogramSnapshot compile_time;
+  HistogramSnapshot interpreter_time;  // time holding the embedded interpreter, compiles included
+  std::vector<KernelMetrics> kernels;
+};
+
+/**
+ * @brief The metrics of all TritonJITFunctions at a point in time, see
+ * TritonJITFunction::snapshot_metrics.
+ */
+struct MetricsSnapshot {
+  std::vector<FunctionMetrics> functions;
+
+  std::string to_json() const;
+  /* the Prometheus text exposition format, functions & kernels are told apart by labels */
+  std::string to_prometheus() const;
+};
+
+}  // namespace triton_jit
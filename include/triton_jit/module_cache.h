@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cuda.h"
+
+namespace triton_jit {
+
+/**
+ * @brief A read-only memory mapping of a whole file.
+ */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const void *data() const {
+    return this->data_;
+  }
+  size_t size() const {
+    return this->size_;
+  }
+
+ private:
+  void *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+/**
+ * @brief A cubin in memory, with the hash of its content. A cubin file is mapped into memory
+ * instead of being read, and the mapping lives as long as the image.
+ */
+struct CubinImage {
+  const void *data;
+  size_t size;
+  uint64_t hash;  // FNV-1a of the content
+  std::shared_ptr<const MappedFile> file;  // null if the image is not from a file
+
+  static std::shared_ptr<const CubinImage> from_file(const std::string &path);
+  /* an image in memory, e.g. an embedded one, which should outlive the returned image */
+  static std::shared_ptr<const CubinImage> from_memory(const void *data, size_t size);
+
+  bool same_content(const CubinImage &other) const;
+};
+
+/**
+ * @brief A process-wide table of the modules loaded into each device, keyed by the content of
+ * their cubins.
+ *
+ * Kernels whose cubins are identical, e.g. compiled from different spellings of the same
+ * constexprs or from functions with the same body, share one module per device instead of
+ * loading duplicates. A hit on the hash is confirmed by comparing the contents. A module is
+ * counted once per load, and unloaded when all of them are released.
+ */
+class ModuleTable {
+ public:
+  static ModuleTable &get();
+
+  /* the module of the image in the device, loaded via the driver into the current context if
+   * the device has none yet */
+  CUmodule load(CUdevice device, const std::shared_ptr<const CubinImage> &image);
+  /* release a load of the image in the device, unloading the module on the last release */
+  void release(CUdevice device, const CubinImage &image);
+
+  /* number of modules loaded, over all devices */
+  size_t num_modules() const;
+
+ private:
+  ModuleTable() = default;
+
+  struct Entry {
+    CUdevice device;
+    std::shared_ptr<const CubinImage> image;
+    CUmodule module;
+    size_t refs;
+  };
+  mutable std::mutex mutex_;
+  std::unordered_map<uint64_t, std::vector<Entry>> modules_;  // hash of the cubin -> modules
+};
+
+}  // namespace triton_jit
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <shared_mutex>
+
+namespace triton_jit {
+
+/* a small id of the calling thread: threads are numbered round-robin on their first call, the id of
+ * a thread never changes. Per-thread shards of a structure are picked by it */
+inline size_t thread_shard_index() {
+  static std::atomic<size_t> next_index {0};
+  thread_local const size_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+/**
+ * @brief A reader-writer lock for read-mostly data, with one shard per reader thread.
+ *
+ * Each thread takes the shared lock of its own shard, so readers on different threads do not
+ * touch the same cache line. A writer takes the exclusive locks of all shards, in order. It
+ * meets the requirements of SharedMutex, so it works with std::shared_lock and
+ * std::unique_lock. Writers are expected to be rare (cache misses, registrations).
+ */
+class ShardedSharedMutex {
+ public:
+  static constexpr size_t NUM_SHARDS = 16;
+
+  ShardedSharedMutex() = default;
+  ShardedSharedMutex(const ShardedSharedMutex &) = delete;
+  ShardedSharedMutex &operator=(const ShardedSharedMutex &) = delete;
+
+  void lock_shared() {
+    this->shards_[thread_shard()].mutex.lock_shared();
+  }
+
+  bool try_lock_shared() {
+    return this->shards_[thread_shard()].mutex.try_lock_shared();
+  }
+
+  void unlock_shared() {
+    this->shards_[thread_shard()].mutex.unlock_shared();
+  }
+
+  void lock() {
+    for (Shard &s : this->shards_) {
+      s.mutex.lock();
+    }
+  }
+
+  bool try_lock() {
+    for (size_t i = 0; i < NUM_SHARDS; i++) {
+      if (!this->shards_[i].mutex.try_lock()) {
+        for (size_t j = i; j > 0; j--) {
+          this->shards_[j - 1].mutex.unlock();
+        }
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void unlock() {
+    for (size_t i = NUM_SHARDS; i > 0; i--) {
+      this->shards_[i - 1].mutex.unlock();
+    }
+  }
+
+ private:
+  struct alignas(64) Shard {
+    std::shared_mutex mutex;
+  };
+
+  static size_t thread_shard() {
+    return thread_shard_index() % NUM_SHARDS;
+  }
+
+  std::array<Shard, NUM_SHARDS> shards_;
+};
+
+}  // namespace triton_jit
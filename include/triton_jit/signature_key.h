@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "triton_jit/compile_options.h"
+#include "triton_jit/small_vector.h"
+
+namespace triton_jit {
+
+/**
+ * @brief Data types of the triton language that may appear in a signature.
+ *
+ * The enumerators are used as compact codes in SignatureKey, their spellings in a full
+ * signature are given by triton_typename.
+ */
+enum struct TritonType : uint8_t {
+  I1 = 0,
+  I8,
+  I16,
+  I32,
+  I64,
+  U8,
+  U16,
+  U32,
+  U64,
+  FP16,
+  BF16,
+  FP32,
+  FP64,
+};
+
+constexpr const char *triton_typename(TritonType t) {
+  constexpr const char *names[] = {
+      "i1", "i8", "i16", "i32", "i64", "u8", "u16", "u32", "u64", "fp16", "bf16", "fp32", "fp64"};
+  return names[static_cast<uint8_t>(t)];
+}
+
+/**
+ * @brief Specialization of an argument: divisible by 16, equals 1, or neither.
+ */
+enum struct Spec : uint8_t {
+  NONE = 0,
+  ONE = 1,
+  DIV16 = 16,
+};
+
+template <typename T>
+constexpr Spec spec_of(T v) {
+  return v % 16 == 0 ? Spec::DIV16 : v == 1 ? Spec::ONE : Spec::NONE;
+}
+
+constexpr const char *spec_suffix(Spec s) {
+  return s == Spec::DIV16 ? ":16" : s == Spec::ONE ? ":1" : "";
+}
+
+/**
+ * @brief A binary representation of the full signature of a triton jit function.
+ *
+ * It is the allocation-free counterpart of the string signature described in the README.
+ * Each argument is encoded as one tag word (kind, data type and specialization), and
+ * constexpr arguments are followed by one more word that holds the bit pattern of the value.
+ * The hash is accumulated while the key is built, so looking it up costs no more than
+ * comparing the words.
+ *
+ * The string signature, which is what standalone_compile.py consumes, is only rendered from
+ * the key when it is required, typically on a cache miss.
+ */
+class SignatureKey {
+ public:
+  enum struct Kind : uint8_t {
+    POINTER = 1,
+    SCALAR = 2,
+    NULLOPT = 3,
+    CONSTEXPR_INT = 4,
+    CONSTEXPR_UINT = 5,
+    CONSTEXPR_BOOL = 6,
+    CONSTEXPR_FP64 = 7,
+    CONSTEXPR_FP32 = 8,
+  };
+
+  void reserve(size_t num_args) {
+    this->words_.reserve(num_args);
+  }
+
+  void push_pointer(TritonType dtype, Spec spec = Spec::NONE) {
+    this->push_word(pointer_word(dtype, spec));
+  }
+
+  void push_scalar(TritonType dtype, Spec spec = Spec::NONE) {
+    this->push_word(scalar_word(dtype, spec));
+  }
+
+  void push_nullopt() {
+    this->push_word(nullopt_word());
+  }
+
+  template <typename T>
+  void push_constexpr(const T &value) {
+    auto [tag_word, bits] = constexpr_words(value);
+    this->push_word(tag_word);
+    this->push_word(bits);
+  }
+
+  /* the words of arguments, so that arguments can be compared with a key without building one */
+  static constexpr uint64_t pointer_word(TritonType dtype, Spec spec) {
+    return tag(Kind::POINTER, dtype, spec);
+  }
+  static constexpr uint64_t scalar_word(TritonType dtype, Spec spec) {
+    return tag(Kind::SCALAR, dtype, spec);
+  }
+  static constexpr uint64_t nullopt_word() {
+    return tag(Kind::NULLOPT, TritonType::I1, Spec::NONE);
+  }
+  /* the tag & value words of a constexpr. Integers are keyed by their values in triton rather
+   * than their C++ types, so that the key is the same as the one parsed from the signature it
+   * renders to: they are int64 unless they do not fit. Floats keep their width, so that they
+   * render as the shortest string that round-trips as a float, e.g. 0.1f as 0.1 */
+  template <typename T>
+  static std::pair<uint64_t, uint64_t> constexpr_words(const T &value) {
+    using U = std::remove_cv_t<std::remove_reference_t<T>>;
+    static_assert(std::is_arithmetic_v<U>, "constexpr arguments should be of arithmetic types");
+    uint64_t bits = 0;
+    Kind kind;
+    if constexpr (std::is_same_v<U, bool>) {
+      kind = Kind::CONSTEXPR_BOOL;
+      bits = value ? 1 : 0;
+    } else if constexpr (std::is_same_v<U, float>) {
+      kind = Kind::CONSTEXPR_FP32;
+      std::memcpy(&bits, &value, sizeof(float));
+    } else if constexpr (std::is_floating_point_v<U>) {
+      kind = Kind::CONSTEXPR_FP64;
+      double v = static_cast<double>(value);
+      std::memcpy(&bits, &v, sizeof(double));
+    } else if constexpr (std::is_signed_v<U>) {
+      kind = Kind::CONSTEXPR_INT;
+      bits = static_cast<uint64_t>(static_cast<int64_t>(value));
+    } else {
+      bits = static_cast<uint64_t>(value);
+      kind = bits > static_cast<uint64_t>(INT64_MAX) ? Kind::CONSTEXPR_UINT : Kind::CONSTEXPR_INT;
+    }
+    return {tag(kind, TritonType::I1, Spec::NONE), bits};
+  }
+
+  size_t hash() const {
+    return this->hash_;
+  }
+
+  size_t num_words() const {
+    return this->words_.size();
+  }
+
+  uint64_t word(size_t i) const {
+    return this->words_[i];
+  }
+
+  bool operator==(const SignatureKey &other) const {
+    return this->hash_ == other.hash_ && this->words_.size() == other.words_.size() &&
+           std::memcmp(this->words_.data(), other.words_.data(), this->words_.size() * sizeof(uint64_t)) ==
+               0;
+  }
+
+  bool operator!=(const SignatureKey &other) const {
+    return !(*this == other);
+  }
+
+  /**
+   * Whether a kernel compiled for this signature can run arguments that produce the signature
+   * `specialized`. It holds when both are equal except that some arguments with a divisibility
+   * hint (:16) in `specialized` have none here. Arguments equal to 1 (:1) are not relaxed, since
+   * they are not passed to the kernel.
+   */
+  bool relaxes(const SignatureKey &specialized) const;
+
+  /**
+   * Render the full signature as a string, e.g. "*fp32:16,*fp32:16,i64,1024".
+   */
+  std::string to_signature() const;
+
+  /**
+   * Parse a full signature in its string form. It is the inverse of to_signature, up to the width
+   * of float constexprs: reals are parsed as fp64, which render to the same string.
+   */
+  static SignatureKey from_signature(std::string_view signature);
+
+ private:
+  static constexpr uint64_t tag(Kind kind, TritonType dtype, Spec spec) {
+    return static_cast<uint64_t>(kind) | (static_cast<uint64_t>(dtype) << 8) |
+           (static_cast<uint64_t>(spec) << 16);
+  }
+
+  void push_word(uint64_t w) {
+    this->words_.push_back(w);
+    // FxHash-style mixing, it is cheap enough to run for every argument
+    constexpr uint64_t K = 0x517cc1b727220a95ULL;
+    this->hash_ = ((this->hash_ << 5 | this->hash_ >> 59) ^ w) * K;
+  }
+
+  SmallVector<uint64_t, 16> words_;
+  uint64_t hash_ = 0;
+};
+
+/**
+ * @brief The key of a compiled kernel in the per-TritonJITFunction cache: full signature,
+ * compile options, and the cuda arch it is compiled for. Devices of the same arch share a kernel,
+ * which is loaded into each of them lazily.
+ */
+struct KernelKey {
+  SignatureKey signature;
+  CompileOptions options;
+  unsigned int arch;
+
+  bool operator==(const KernelKey &other) const {
+    return this->arch == other.arch && this->signature == other.signature && this->options == other.options;
+  }
+};
+
+struct KernelKeyHash {
+  size_t operator()(const KernelKey &k) const {
+    uint64_t h = k.signature.hash();
+    h ^= k.options.hash() ^ static_cast<uint64_t>(k.arch);
+    return h * 0x9e3779b97f4a7c15ULL;
+  }
+};
+
+}  // namespace triton_jit
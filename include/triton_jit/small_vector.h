@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace triton_jit {
+
+/**
+ * @brief A vector of trivially copyable elements, stored inline for up to N of them.
+ *
+ * It is what the launch path needs of c10::SmallVector: elements are copied with memcpy, and the
+ * storage is only allocated on the heap when it outgrows the inline one. Growing value-initializes
+ * the new elements.
+ */
+template <typename T, size_t N = 8>
+class SmallVector {
+  static_assert(std::is_trivially_copyable_v<T>, "SmallVector holds trivially copyable elements");
+  static_assert(N > 0, "SmallVector needs inline storage");
+
+ public:
+  SmallVector() = default;
+  SmallVector(size_t n, const T &value) {
+    this->resize(n, value);
+  }
+  SmallVector(const T *first, const T *last) {
+    this->assign(first, last);
+  }
+  SmallVector(const SmallVector &other) {
+    this->assign(other.begin(), other.end());
+  }
+  SmallVector(SmallVector &&other) noexcept {
+    this->steal(other);
+  }
+  SmallVector &operator=(const SmallVector &other) {
+    if (this != &other) {
+      this->assign(other.begin(), other.end());
+    }
+    return *this;
+  }
+  SmallVector &operator=(SmallVector &&other) noexcept {
+    if (this != &other) {
+      this->release();
+      this->steal(other);
+    }
+    return *this;
+  }
+  ~SmallVector() {
+    this->release();
+  }
+
+  size_t size() const {
+    return this->size_;
+  }
+  size_t capacity() const {
+    return this->capacity_;
+  }
+  bool empty() const {
+    return this->size_ == 0;
+  }
+  T *data() {
+    return this->data_;
+  }
+  const T *data() const {
+    return this->data_;
+  }
+  T *begin() {
+    return this->data_;
+  }
+  T *end() {
+    return this->data_ + this->size_;
+  }
+  const T *begin() const {
+    return this->data_;
+  }
+  const T *end() const {
+    return this->data_ + this->size_;
+  }
+  T &operator[](size_t i) {
+    return this->data_[i];
+  }
+  const T &operator[](size_t i) const {
+    return this->data_[i];
+  }
+
+  void reserve(size_t new_cap) {
+    if (new_cap <= this->capacity_) {
+      return;
+    }
+    T *storage = static_cast<T *>(std::malloc(new_cap * sizeof(T)));
+    if (!storage) {
+      throw std::bad_alloc();
+    }
+    std::memcpy(storage, this->data_, this->size_ * sizeof(T));
+    if (!this->is_inline()) {
+      std::free(this->data_);
+    }
+    this->data_ = storage;
+    this->capacity_ = new_cap;
+  }
+
+  void resize(size_t n, const T &value = T()) {
+    if (n > this->capacity_) {
+      this->reserve(std::max(n, 2 * this->capacity_));
+    }
+    for (size_t i = this->size_; i < n; i++) {
+      this->data_[i] = value;
+    }
+    this->size_ = n;
+  }
+
+  void push_back(const T &value) {
+    if (this->size_ == this->capacity_) {
+      // value may be an element of this vector
+      T copy = value;
+      this->reserve(2 * this->capacity_);
+      this->data_[this->size_++] = copy;
+      return;
+    }
+    this->data_[this->size_++] = value;
+  }
+
+  void clear() {
+    this->size_ = 0;
+  }
+
+ private:
+  bool is_inline() const {
+    return this->data_ == reinterpret_cast<const T *>(this->inline_);
+  }
+
+  void assign(const T *first, const T *last) {
+    size_t n = static_cast<size_t>(last - first);
+    this->size_ = 0;
+    this->reserve(n);
+    std::memcpy(this->data_, first, n * sizeof(T));
+    this->size_ = n;
+  }
+
+  /* take the elements of other, leaving it empty */
+  void steal(SmallVector &other) {
+    if (other.is_inline()) {
+      this->assign(other.begin(), other.end());
+    } else {
+      this->data_ = other.data_;
+      this->size_ = other.size_;
+      this->capacity_ = other.capacity_;
+      other.data_ = reinterpret_cast<T *>(other.inline_);
+      other.capacity_ = N;
+    }
+    other.size_ = 0;
+  }
+
+  void release() {
+    if (!this->is_inline()) {
+      std::free(this->data_);
+    }
+    this->data_ = reinterpret_cast<T *>(this->inline_);
+    this->size_ = 0;
+    this->capacity_ = N;
+  }
+
+  alignas(T) std::byte inline_[N * sizeof(T)];
+  T *data_ = reinterpret_cast<T *>(this->inline_);
+  size_t size_ = 0;
+  size_t capacity_ = N;
+};
+
+}  // namespace triton_jit
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace triton_jit {
+
+/**
+ * @brief Overrides of how the arguments of a jit function are specialized, see
+ * TritonJITFunction::get_instance. By default, an argument is specialized unless it is marked
+ * `do_not_specialize` in python: pointers get :16 if they are 16-byte aligned, and integers get
+ * :16 if they are multiples of 16 or :1 if they are 1. Arguments are referred to by their
+ * indices, constexpr arguments cannot be overridden.
+ */
+class SpecializationPolicy {
+ public:
+  enum class Mode : int8_t {
+    DEFAULT = 0,
+    SPECIALIZE = 1,
+    DO_NOT_SPECIALIZE = 2,
+  };
+  struct Arg {
+    Mode mode = Mode::DEFAULT;
+    // the pointer is asserted to be 16-byte aligned, so it always gets :16
+    bool assume_aligned = false;
+    // the integer never gets :1, so that it stays an argument of the kernel when it is 1
+    bool never_one = false;
+  };
+
+  SpecializationPolicy &specialize(int index) {
+    this->args_[index].mode = Mode::SPECIALIZE;
+    return *this;
+  }
+  SpecializationPolicy &do_not_specialize(int index) {
+    this->args_[index].mode = Mode::DO_NOT_SPECIALIZE;
+    return *this;
+  }
+  /* it implies specialize */
+  SpecializationPolicy &assume_aligned(int index) {
+    this->args_[index].mode = Mode::SPECIALIZE;
+    this->args_[index].assume_aligned = true;
+    return *this;
+  }
+  SpecializationPolicy &never_one(int index) {
+    this->args_[index].never_one = true;
+    return *this;
+  }
+
+  const std::map<int, Arg> &args() const {
+    return this->args_;
+  }
+  bool empty() const {
+    return this->args_.empty();
+  }
+  /* a canonical form, e.g. "0:spec,aligned;3:nospec", empty if there are no overrides */
+  std::string to_string() const;
+
+ private:
+  std::map<int, Arg> args_;
+};
+
+/**
+ * @brief Which arguments of a jit function vary between the signatures of its compiled kernels,
+ * see TritonJITFunction::specialization_report.
+ */
+struct SpecializationReport {
+  struct Argument {
+    int index;
+    // each value of the argument in the signatures, e.g. "*fp32:16" & "*fp32", with the number of
+    // signatures of that value
+    std::vector<std::pair<std::string, size_t>> values;
+  };
+  size_t num_variants = 0;  // distinct signatures compiled
+  std::vector<Argument> arguments;  // arguments with more than one value, by index
+
+  /* e.g. "3 variants; argument 0: *fp32:16 (2), *fp32 (1); argument 3: 64 (1), 128 (2)" */
+  std::string to_string() const;
+};
+
+/**
+ * @brief Records the signatures a jit function is compiled for, to find the arguments whose
+ * specialization (divisibility hints, values of constexprs) multiplies its variants. It is on the
+ * compile path only, so it is guarded by a mutex.
+ */
+class SpecializationTracker {
+ public:
+  /* record the full signature of a compiled kernel, kernels of the same signature with other
+   * compile options or archs are one variant. Returns the report when the number of variants
+   * exceeds max_variants for the first time, 0 for no limit */
+  std::optional<SpecializationReport> record(const std::string &signature, size_t max_variants);
+  SpecializationReport report() const;
+
+ private:
+  SpecializationReport report_locked() const;
+
+  mutable std::mutex mutex_;
+  std::unordered_set<std::string> signatures_;
+  // per argument position: value -> number of signatures
+  std::vector<std::map<std::string, size_t>> values_;
+  bool exceeded_ = false;
+};
+
+}  // namespace triton_jit
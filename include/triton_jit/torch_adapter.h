@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stdexcept>
+#include <type_traits>
+
+#include "torch/torch.h"
+#include "triton_jit/device_ptr.h"
+#include "triton_jit/triton_jit_function.h"
+
+/**
+ * @file torch_adapter.h
+ * @brief Passing torch tensors & scalars to jit functions: a tensor is passed as a DevicePtr of its
+ * data pointer & dtype, a scalar as the C++ value of its type. The rest of the library does not
+ * depend on libtorch, this header is what the triton_jit target (triton_jit_core with torch) adds.
+ */
+namespace triton_jit {
+
+constexpr TritonType to_triton_type(c10::ScalarType t) {
+  switch (t) {
+    case c10::ScalarType::Float:
+      return TritonType::FP32;
+    case c10::ScalarType::Double:
+      return TritonType::FP64;
+    case c10::ScalarType::Half:
+      return TritonType::FP16;
+    case c10::ScalarType::BFloat16:
+      return TritonType::BF16;
+    case c10::ScalarType::Int:
+      return TritonType::I32;
+    case c10::ScalarType::Long:
+      return TritonType::I64;
+    case c10::ScalarType::Short:
+      return TritonType::I16;
+    case c10::ScalarType::UInt32:
+      return TritonType::U32;
+    case c10::ScalarType::UInt64:
+      return TritonType::U64;
+    case c10::ScalarType::UInt16:
+      return TritonType::U16;
+    case c10::ScalarType::Char:
+      return TritonType::I8;
+    case c10::ScalarType::Byte:
+      return TritonType::U8;
+    case c10::ScalarType::Bool:
+      return TritonType::I1;
+    default:
+      throw std::runtime_error("<unsupported_type>");
+  }
+}
+
+constexpr const char *to_triton_typename(c10::ScalarType t) {
+  return triton_typename(to_triton_type(t));
+}
+
+template <typename T, typename = void>
+struct has_data_ptr : std::false_type {};
+
+template <typename T>
+struct has_data_ptr<
+    T,
+    std::enable_if_t<std::conjunction_v<
+        std::is_same<decltype(std::declval<std::remove_reference_t<T>>().data_ptr()), void *>,
+        std::is_same<decltype(std::declval<std::remove_reference_t<T>>().scalar_type()), c10::ScalarType>>>>
+    : std::true_type {};
+
+template <typename T>
+struct is_scalar_helper : public std::false_type {};
+
+template <>
+struct is_scalar_helper<c10::Scalar> : public std::true_type {};
+
+template <typename T>
+struct is_scalar : public is_scalar_helper<std::remove_const_t<std::remove_reference_t<T>>> {};
+
+template <>
+struct ArgAdapter<at::Tensor> {
+  static constexpr bool is_pointer = true;
+
+  template <typename F>
+  static auto apply(const at::Tensor &item, F &&f) {
+    return f(DevicePtr<void>(item.data_ptr(), to_triton_type(item.scalar_type())));
+  }
+};
+
+template <>
+struct ArgAdapter<c10::Scalar> {
+  static constexpr bool is_pointer = false;
+
+  template <typename F>
+  static auto apply(const c10::Scalar &item, F &&f) {
+    TORCH_CHECK(!item.isSymbolic());
+    c10::ScalarType tp = item.type();
+    const void *p = item.data_ptr();
+    if (tp == c10::ScalarType::Bool) {
+      return f(*reinterpret_cast<const bool *>(p));
+    } else if (tp == c10::ScalarType::Long) {
+      return f(*reinterpret_cast<const int64_t *>(p));
+    } else if (tp == c10::ScalarType::UInt64) {
+      return f(*reinterpret_cast<const uint64_t *>(p));
+    } else if (tp == c10::ScalarType::Double) {
+      return f(*reinterpret_cast<const double *>(p));
+    } else {
+      throw std::runtime_error("unsupported scalar type.");
+    }
+  }
+};
+
+}  // namespace triton_jit
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace triton_jit {
+
+/**
+ * @brief A span of the runtime: looking up a static signature, compiling a kernel, loading a
+ * module or launching a kernel. Strings are truncated so that an event is trivially copyable.
+ */
+struct TraceEvent {
+  const char *name;  // a string literal
+  int64_t start_ns;  // since the tracer was created
+  int64_t duration_ns;
+  int device;         // -1 if the span is not on a device
+  unsigned int arch;  // 0 if the span is not for an arch
+  char function[48];
+  char signature[112];
+};
+
+/**
+ * @brief An opt-in recorder of runtime spans, which exports them in the Chrome trace event format,
+ * to be opened in Perfetto or chrome://tracing.
+ *
+ * Each thread records into a ring buffer of its own, without locks, keeping its last
+ * BUFFER_EVENTS events. A buffer is registered once per thread, and outlives the thread so that
+ * its events are still exported. When disabled, a span costs a relaxed load. Setting
+ * `TRITON_JIT_TRACE=<path>` enables it at startup and writes the trace to the path at exit.
+ */
+class Tracer {
+ public:
+  static constexpr size_t BUFFER_EVENTS = 8192;
+
+  static Tracer &get();
+  Tracer(const Tracer &) = delete;
+  Tracer &operator=(const Tracer &) = delete;
+
+  static bool enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+  static void set_enabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  void record(const TraceEvent &event);
+  int64_t now_ns() const {
+    auto elapsed = std::chrono::steady_clock::now() - this->epoch_;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  }
+
+  /* the events recorded so far, in the Chrome trace event format */
+  std::string to_json() const;
+  void write(const std::string &path) const;
+  /* drop the events recorded so far */
+  void clear();
+
+ private:
+  Tracer() : epoch_(std::chrono::steady_clock::now()) {
+  }
+
+  // written by its thread only; head is published with release semantics after the event is
+  // written, readers drop the events that may have been overwritten while they copy them
+  struct ThreadBuffer {
+    int64_t tid;
+    std::atomic<uint64_t> head {0};
+    std::atomic<uint64_t> tail {0};  // events before it are cleared
+    std::array<TraceEvent, BUFFER_EVENTS> events;
+  };
+  ThreadBuffer &thread_buffer();
+
+  std::chrono::steady_clock::time_point epoch_;
+  mutable std::mutex buffers_mutex_;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+
+  static std::atomic<bool> enabled_;
+};
+
+/**
+ * @brief Records the span from its construction to its destruction, if tracing is enabled when it
+ * is constructed.
+ */
+class TraceSpan {
+ public:
+  explicit TraceSpan(const char *name,
+                     std::string_view function,
+                     std::string_view signature = {},
+                     int device = -1,
+                     unsigned int arch = 0);
+  ~TraceSpan();
+  TraceSpan(const TraceSpan &) = delete;
+  TraceSpan &operator=(const TraceSpan &) = delete;
+
+ private:
+  bool active_;
+  TraceEvent event_;
+};
+
+}  // namespace triton_jit
@@ -11,17 +11,32 @@
  */
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include "cuda.h"
 
 #include "fmt/core.h"
+#include "triton_jit/compile_options.h"
+#include "triton_jit/device_ptr.h"
+#include "triton_jit/driver.h"
 #include "triton_jit/jit_utils.h"
+#include "triton_jit/metrics.h"
+#include "triton_jit/sharded_mutex.h"
+#include "triton_jit/signature_key.h"
+#include "triton_jit/specialization.h"
 #include "triton_jit/triton_kernel.h"
 
 namespace triton_jit {
@@ -46,12 +61,46 @@ enum struct ArgType : int8_t {
 struct StaticSignature {
   int num_args;
   std::vector<ArgType> arg_type;
+  // per argument overrides of the specialization, empty if there are none, see SpecializationPolicy
+  std::vector<SpecializationPolicy::Arg> overrides;
 
   const ArgType &at(size_t i) const {
     return arg_type.at(i);
   }
+  bool assumes_aligned(size_t i) const {
+    return !overrides.empty() && overrides[i].assume_aligned;
+  }
+  bool never_one(size_t i) const {
+    return !overrides.empty() && overrides[i].never_one;
+  }
+};
+
+/**
+ * @brief A request to compile a kernel ahead of its first launch, see
+ * TritonJITFunction::precompile.
+ */
+struct PrecompileRequest {
+  std::string signature;  // full signature in its string form
+  CompileOptions options;
+  CUdevice device_index;
 };
 
+/**
+ * @brief A launch of TritonJITFunction::launch_many: its grid and the arguments to the triton
+ * function.
+ */
+template <typename... Args>
+struct LaunchItem {
+  unsigned int grid_x;
+  unsigned int grid_y;
+  unsigned int grid_z;
+  std::tuple<Args...> args;
+};
+
+template <typename... Args>
+class BoundLauncher;
+struct EmbeddedFunction;
+
 /**
  * @brief An class to wrap triton jit function for it to be called in c++.
  *
@@ -63,31 +112,218 @@ class TritonJITFunction {
   std::string file_path_;
   std::string function_name_;
   StaticSignature static_sig_;
-  // the cached compiled TritonKernel of this TritonJITFunction
-  mutable std::unordered_map<std::string, TritonKernel> overloads_;
+  // the function embedded at build time from this source, if any
+  const EmbeddedFunction *embedded_ = nullptr;
+  // the cached compiled TritonKernel of this TritonJITFunction. Kernels are held by pointers
+  // so that references handed out stay valid; an entry is published under the exclusive lock
+  // and never modified afterwards
+  mutable std::unordered_map<KernelKey, std::unique_ptr<TritonKernel>, KernelKeyHash> overloads_;
+  mutable ShardedSharedMutex overloads_mutex_;
+  // compiles in flight. A miss on a key that is being compiled waits for that compile instead
+  // of starting another one (single-flight), misses on distinct keys compile concurrently
+  mutable std::unordered_map<KernelKey, std::shared_future<const TritonKernel *>, KernelKeyHash> pending_;
+  mutable std::mutex pending_mutex_;
+  // tiered compilation, see set_tiered_compilation
+  std::atomic<bool> tiered_ {false};
+  // launch via CU_LAUNCH_PARAM_BUFFER_POINTER, see set_packed_launch
+  std::atomic<bool> packed_launch_ {false};
+  // metrics, see metrics()
+  mutable Counter cache_hits_;
+  mutable Counter cache_misses_;
+  mutable Histogram compile_time_;
+  mutable Histogram interpreter_time_;
+  // bounded kernel cache, see set_max_kernels
+  std::atomic<size_t> max_kernels_ {0};
+  mutable std::atomic<uint64_t> evictions_ {0};
+  // kernels are looked up and launched within a ScopedKernelUse, counted per thread shard. An
+  // evicted kernel cannot be found by a use that begins after its eviction, so it is unloaded &
+  // freed once no use is held, see free_retired. So are the entries replaced by bound launchers
+  struct alignas(64) Users {
+    std::atomic<int64_t> count {0};
+  };
+  mutable std::array<Users, ShardedSharedMutex::NUM_SHARDS> users_;
+  mutable std::vector<std::unique_ptr<TritonKernel>> retired_;
+  mutable std::vector<std::shared_ptr<const void>> retired_entries_;
+  mutable std::atomic<bool> has_retired_ {false};
+  mutable std::mutex retired_mutex_;
+  // signatures compiled, see specialization_report
+  mutable SpecializationTracker specializations_;
+  std::atomic<size_t> max_variants_;
 
   // a registry to hold all TritonJITFunctions
-  static std::unordered_map<std::string, TritonJITFunction> functions_;
+  static std::unordered_map<std::string, std::unique_ptr<TritonJITFunction>> functions_;
+  static ShardedSharedMutex functions_mutex_;
+  // the bound on the kernels of all functions, the number of them, and the clock of their LRU order
+  static std::atomic<size_t> max_cached_kernels_;
+  static std::atomic<size_t> num_cached_kernels_;
+  static std::atomic<uint64_t> lru_clock_;
 
  public:
-  static TritonJITFunction &get_instance(std::string_view path, std::string_view name);
+  /**
+   * Get or Add a TritonJITFunction. It is thread-safe, concurrent callers asking for the same
+   * function get the same instance. The policy overrides how the arguments are specialized; a
+   * function with another policy is another instance, with kernels of its own.
+   */
+  static TritonJITFunction &get_instance(std::string_view path,
+                                         std::string_view name,
+                                         const SpecializationPolicy &policy = {});
   TritonJITFunction(const TritonJITFunction &) = delete;
   TritonJITFunction &operator=(const TritonJITFunction &) = delete;
-  TritonJITFunction(TritonJITFunction &&) = default;
-  TritonJITFunction &operator=(TritonJITFunction &&) = default;
+  TritonJITFunction(TritonJITFunction &&) = delete;
+  TritonJITFunction &operator=(TritonJITFunction &&) = delete;
 
   const StaticSignature &get_static_sig() const {
     return this->static_sig_;
   }
+
+  /**
+   * @brief Keeps the kernels of a function from being freed on eviction while it lives.
+   *
+   * Launches hold one from looking the kernel up until it is launched, so do callers of
+   * get_kernel when the kernel cache is bounded, see set_max_kernels. It costs an atomic
+   * increment & decrement on a counter of the thread's shard; the last use to end frees the
+   * kernels evicted meanwhile.
+   */
+  class ScopedKernelUse {
+   public:
+    explicit ScopedKernelUse(const TritonJITFunction &function)
+        : function_(function),
+          count_(function.users_[thread_shard_index() % ShardedSharedMutex::NUM_SHARDS].count) {
+      this->count_.fetch_add(1, std::memory_order_seq_cst);
+    }
+    ~ScopedKernelUse() {
+      if (this->count_.fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+          this->function_.has_retired_.load(std::memory_order_seq_cst)) {
+        this->function_.free_retired();
+      }
+    }
+    ScopedKernelUse(const ScopedKernelUse &) = delete;
+    ScopedKernelUse &operator=(const ScopedKernelUse &) = delete;
+
+   private:
+    const TritonJITFunction &function_;
+    std::atomic<int64_t> &count_;
+  };
+
+  /**
+   * Get or Add a TritonKernel corresponding to the signature, compile options and the arch of the
+   * device. Kernels are compiled once per arch and shared by the devices of that arch, each
+   * loading it on its first launch there.
+   * It may trigger triton.compile via the embedded python interpreter. It is thread-safe, a hit
+   * only takes the shared lock of the calling thread's shard. Concurrent misses on the same key
+   * share one compilation.
+   */
+  const TritonKernel &get_kernel(const SignatureKey &signature,
+                                 const CompileOptions &options,
+                                 CUdevice device_index) const;
   /**
-   * Get or Add a TritonKernel corresponding to the signature, compile options and device index.
-   * It may trigger triton.compile via the embedded python interpreter.
+   * The same as above, with the full signature in its string form. The signature is parsed
+   * into a SignatureKey, so it shares the cache with the binary one.
    */
   const TritonKernel &get_kernel(std::string_view signature,
+                                 const CompileOptions &options,
+                                 CUdevice device_index) const;
+  /* with the default options besides num_warps & num_stages */
+  const TritonKernel &get_kernel(const SignatureKey &signature,
                                  int num_warps,
                                  int num_stages,
-                                 CUdevice device_index) const;
+                                 CUdevice device_index) const {
+    return this->get_kernel(signature, CompileOptions(num_warps, num_stages), device_index);
+  }
+  const TritonKernel &get_kernel(std::string_view signature,
+                                 int num_warps,
+                                 int num_stages,
+                                 CUdevice device_index) const {
+    return this->get_kernel(signature, CompileOptions(num_warps, num_stages), device_index);
+  }
 
+  /**
+   * Opt into tiered compilation. On a miss, the specialized kernel is compiled in the background
+   * and, if a compatible less-specialized kernel of this function is already compiled (the same
+   * signature with some divisibility hints dropped, see SignatureKey::relaxes), get_kernel returns
+   * that one instead of waiting. Once the specialized kernel is compiled it is published to the
+   * cache and later launches pick it up. Without a compatible kernel, get_kernel waits as usual.
+   */
+  void set_tiered_compilation(bool enabled) {
+    this->tiered_.store(enabled, std::memory_order_relaxed);
+  }
+
+  /**
+   * Pass the arguments of operator() to the kernel as one block in the kernel parameter layout,
+   * via CU_LAUNCH_PARAM_BUFFER_POINTER, instead of an array of pointers to each of them.
+   */
+  void set_packed_launch(bool enabled) {
+    this->packed_launch_.store(enabled, std::memory_order_relaxed);
+  }
+
+  /**
+   * Bound the number of kernels cached by this function, 0 (the default) for no bound besides the
+   * process-wide one. When a new kernel exceeds a bound, the least recently used kernel is evicted:
+   * it leaves the cache, and it is unloaded & freed once no ScopedKernelUse of this function is
+   * held. A later miss on its key loads it via the kernel index (or the embedded kernels), without
+   * compiling it again. References from get_kernel or precompile are valid within a use.
+   */
+  void set_max_kernels(size_t max_kernels);
+  /**
+   * Bound the number of kernels cached by all functions, 0 for no bound. The default is
+   * TRITON_JIT_MAX_KERNELS, or no bound.
+   */
+  static void set_max_cached_kernels(size_t max_kernels);
+
+  /**
+   * Which arguments vary between the signatures this function is compiled for, with their values.
+   * Divisibility hints of pointers (:16) depend on the alignment of tensors, those of integers
+   * and constexprs on their values, so they may multiply the variants of a function. When the
+   * variants exceed max_variants (TRITON_JIT_MAX_VARIANTS, 8 by default, 0 to disable), this
+   * report is logged once.
+   */
+  SpecializationReport specialization_report() const {
+    return this->specializations_.report();
+  }
+  void set_max_variants(size_t max_variants) {
+    this->max_variants_.store(max_variants, std::memory_order_relaxed);
+  }
+
+  /**
+   * Compile a kernel in the background, without launching it. The returned future becomes ready
+   * when the kernel is in the cache, or holds the exception if the compilation failed. A
+   * get_kernel for the same key while it is in flight waits for it instead of compiling again.
+   * Background compiles run on a process-wide pool of TRITON_JIT_COMPILE_THREADS threads.
+   */
+  std::shared_future<const TritonKernel *> precompile(std::string_view signature,
+                                                      const CompileOptions &options,
+                                                      CUdevice device_index) const;
+  std::shared_future<const TritonKernel *> precompile(std::string_view signature,
+                                                      int num_warps,
+                                                      int num_stages,
+                                                      CUdevice device_index) const {
+    return this->precompile(signature, CompileOptions(num_warps, num_stages), device_index);
+  }
+  /**
+   * Batch version of precompile, the futures are in the order of the requests.
+   */
+  std::vector<std::shared_future<const TritonKernel *>> precompile(
+      const std::vector<PrecompileRequest> &requests) const;
+
+  /**
+   * The metrics of this function and its cached kernels. Counters are per thread on the launch
+   * path, they are summed here.
+   */
+  FunctionMetrics metrics() const;
+  /**
+   * The metrics of all functions, e.g. to be serialized via MetricsSnapshot::to_json or
+   * MetricsSnapshot::to_prometheus.
+   */
+  static MetricsSnapshot snapshot_metrics();
+
+  template <typename... Args>
+  void operator()(CUstream stream,
+                  unsigned int grid_x,
+                  unsigned int grid_y,
+                  unsigned int grid_z,
+                  const CompileOptions &options,
+                  Args... args) const;
+  /* with the default options besides num_warps & num_stages */
   template <typename... Args>
   void operator()(CUstream stream,
                   unsigned int grid_x,
@@ -95,7 +331,44 @@ class TritonJITFunction {
                   unsigned int grid_z,
                   unsigned int num_warps,
                   unsigned int num_stages,
-                  Args... args) const;
+                  Args... args) const {
+    (*this)(stream, grid_x, grid_y, grid_z, CompileOptions(num_warps, num_stages), args...);
+  }
+
+  /**
+   * Launch the function once per item, in order, with the same compile options, e.g. for the
+   * chunks of a tensor list. The arguments of all items are packed back to back into one buffer
+   * leased for the batch, and the kernel is looked up once per run of consecutive items of the
+   * same signature; only an item whose specialization differs from the previous one (e.g. an
+   * unaligned pointer) looks up its own kernel. Launches of a run are issued in a tight loop, see
+   * TritonKernel::launch_many.
+   */
+  template <typename... Args>
+  void launch_many(CUstream stream,
+                   const CompileOptions &options,
+                   const std::vector<LaunchItem<Args...>> &items) const;
+  template <typename... Args>
+  void launch_many(CUstream stream,
+                   unsigned int num_warps,
+                   unsigned int num_stages,
+                   const std::vector<LaunchItem<Args...>> &items) const {
+    this->launch_many(stream, CompileOptions(num_warps, num_stages), items);
+  }
+
+  /**
+   * Bind the compile options and the C++ types of the arguments of a callsite, e.g.
+   * `f.bind<at::Tensor, at::Tensor, int64_t, int64_t>(8, 1)`. The returned launcher takes the
+   * arguments by reference, and remembers the kernel of its last signature, so that a callsite
+   * which keeps passing arguments of the same dtypes and alignments skips the kernel cache.
+   */
+  template <typename... Args>
+  BoundLauncher<std::decay_t<Args>...> bind(const CompileOptions &options) const {
+    return BoundLauncher<std::decay_t<Args>...>(*this, options);
+  }
+  template <typename... Args>
+  BoundLauncher<std::decay_t<Args>...> bind(int num_warps, int num_stages) const {
+    return BoundLauncher<std::decay_t<Args>...>(*this, CompileOptions(num_warps, num_stages));
+  }
 
   /**
    * A Low level API to launch Triton Kernel directly with pointers to all kernel args. This is
@@ -103,6 +376,13 @@ class TritonJITFunction {
    * designed to be used manual argument processing. An argument-buffer-like design is working in
    * progress now to support more flexible argument processing.
    */
+  void launch_with_raw_args(CUstream stream,
+                            unsigned int grid_x,
+                            unsigned int grid_y,
+                            unsigned int grid_z,
+                            const CompileOptions &options,
+                            std::string full_signature,
+                            void **args) const;
   void launch_with_raw_args(CUstream stream,
                             unsigned int grid_x,
                             unsigned int grid_y,
@@ -110,10 +390,67 @@ class TritonJITFunction {
                             unsigned int num_warps,
                             unsigned int num_stages,
                             std::string full_signature,
-                            void **args) const;
+                            void **args) const {
+    this->launch_with_raw_args(stream,
+                               grid_x,
+                               grid_y,
+                               grid_z,
+                               CompileOptions(num_warps, num_stages),
+                               std::move(full_signature),
+                               args);
+  }
 
  private:
-  TritonJITFunction(std::string_view path, std::string_view name);
+  friend class TritonAutotuner;
+  template <typename... Args>
+  friend class BoundLauncher;
+  TritonJITFunction(std::string_view path, std::string_view name, const SpecializationPolicy &policy);
+  /* override the static signature by the policy */
+  void apply_policy(const SpecializationPolicy &policy);
+  /* run gen_ssig.py in a worker process or the embedded python interpreter */
+  std::vector<int> extract_static_signature() const;
+  /* configs & key of the Autotuner wrapping the function, in json, "null" if it is not autotuned */
+  std::string extract_autotune_configs() const;
+  /* absolute path and content hash of the source file, for the kernel index */
+  std::string source_path() const;
+  std::optional<uint64_t> source_hash() const;
+  /* look up the cache, returns nullptr on a miss */
+  const TritonKernel *find_kernel(const KernelKey &key) const;
+  /* look up a cached kernel that is able to run the arguments of the key, returns nullptr if none */
+  const TritonKernel *find_relaxed_kernel(const KernelKey &key) const;
+  /* compile the kernel for the key unless it is compiled or being compiled already, in this thread
+   * or in the background. Returns the future of the compile for the key */
+  std::shared_future<const TritonKernel *> schedule_compile(const KernelKey &key, bool async) const;
+  void run_compile(const KernelKey &key, std::promise<const TritonKernel *> &promise) const;
+  /* look up the embedded kernels & the kernel index, then invoke the compiler */
+  std::unique_ptr<TritonKernel> compile_kernel(const KernelKey &key) const;
+  /* compile for the arch in a worker process if enabled, or in the embedded python interpreter;
+   * returns the directory of the compiled kernel */
+  std::string run_compiler(const std::string &signature,
+                           const CompileOptions &options,
+                           unsigned int arch) const;
+  const TritonKernel *publish_kernel(const KernelKey &key, std::unique_ptr<TritonKernel> kernel) const;
+  /* mark a cached kernel as used, for the LRU order. It writes only if the clock moved since its
+   * last use, so that hits on the same kernel do not bounce a cache line between threads */
+  static void touch(const TritonKernel *kernel) {
+    uint64_t now = lru_clock_.load(std::memory_order_relaxed);
+    if (kernel->last_used_.load(std::memory_order_relaxed) != now) {
+      kernel->last_used_.store(now, std::memory_order_relaxed);
+    }
+  }
+  size_t num_kernels() const;
+  /* evict kernels until the bounds hold, sparing `keep` */
+  void enforce_cache_bounds(const TritonKernel *keep) const;
+  static void enforce_global_bound(const TritonKernel *keep);
+  /* the last use of the least recently used kernel of this function but `keep`, if any */
+  std::optional<uint64_t> oldest_use(const TritonKernel *keep) const;
+  /* evict the least recently used kernel of this function but `keep`, false if there is none */
+  bool evict_lru(const TritonKernel *keep) const;
+  /* free an entry of a bound launcher, which launches may still read, once no use is held */
+  void retire(std::shared_ptr<const void> entry) const;
+  /* unload & free the evicted kernels unless a use is held. A kernel with a launch in flight via a
+   * reference held without a use is retried later */
+  void free_retired() const;
 };
 
 struct ArgHandle {
@@ -123,7 +460,8 @@ struct ArgHandle {
   by Storage. We gather data pointers here for them to live out of the loop while iterating
   over arguments.*/
   ParameterBuffer &buf;
-  c10::SmallVector<std::string> &signature;
+  /* binary full signature, rendered into a string only when a kernel has to be compiled */
+  SignatureKey &signature;
   int idx;
 
   /***
@@ -139,8 +477,8 @@ struct ArgHandle {
   void handle_arg(const T &item) {
     if constexpr (is_optional<decltype(item)>::value) {
       handle_optional(item);
-    } else if constexpr (is_same_ignore_cvref<c10::Scalar, T>::value) {
-      handle_scalar(item);
+    } else if constexpr (has_arg_adapter<T>::value) {
+      ArgAdapter<std::remove_cv_t<T>>::apply(item, [this](const auto &v) { this->handle_arg(v); });
     } else {
       handle_arg_plain(item);
     }
@@ -156,32 +494,19 @@ struct ArgHandle {
     }
   }
 
-  void handle_scalar(const c10::Scalar &item) {
-    TORCH_CHECK(!item.isSymbolic());
-    c10::ScalarType tp = item.type();
-    const void *p = item.data_ptr();
-    if (tp == c10::ScalarType::Bool) {
-      handle_arg_plain(*reinterpret_cast<const bool *>(p));
-    } else if (tp == c10::ScalarType::Long) {
-      handle_arg_plain(*reinterpret_cast<const int64_t *>(p));
-    } else if (tp == c10::ScalarType::UInt64) {
-      handle_arg_plain(*reinterpret_cast<const uint64_t *>(p));
-    } else if (tp == c10::ScalarType::Double) {
-      handle_arg_plain(*reinterpret_cast<const double *>(p));
-    } else {
-      throw std::runtime_error("unsupported scalar type.");
-    }
-  }
-
   template <typename T>
   void handle_arg_plain(const T &item) {
-    if constexpr (is_same_ignore_cvref<at::Tensor, T>::value) {
-      handle_tensor(item);
-    } else if constexpr (is_same_ignore_cvref<std::nullopt_t, T>::value) {
+    using U = std::remove_cv_t<std::remove_reference_t<T>>;
+    if constexpr (is_device_ptr<U>::value) {
+      handle_pointer(item.get(), item.dtype());
+    } else if constexpr (std::is_same_v<std::nullopt_t, U>) {
       // Assumption nullopt is alway treated as constexpr,
       // even if the parameter is not marked as constexpr
-      signature.push_back("nullopt");
+      signature.push_nullopt();
     } else {
+      static_assert(std::is_arithmetic_v<U> || std::is_same_v<std::nullptr_t, U>,
+                    "Arguments are DevicePtrs, scalars, std::nullopt or types with an ArgAdapter, "
+                    "include triton_jit/torch_adapter.h to pass torch tensors & scalars");
       if (ssig.at(idx) == ArgType::CONSTEXPR) {  // constexpr
         handle_constexpr(item);
       } else if (ssig.at(idx) == ArgType::SPECIALIZED) {  // specialzied
@@ -193,57 +518,68 @@ struct ArgHandle {
     idx++;
   }
 
-  void handle_tensor(const at::Tensor &item) {
-    // Assumuption: Tensor is never constexpr
-    TORCH_CHECK(this->ssig.at(idx) != ArgType::CONSTEXPR);
-    void *p_item = item.data_ptr();
+  void handle_pointer(const void *item, TritonType dtype) {
+    // Assumuption: a pointer is never constexpr
+    if (this->ssig.at(idx) == ArgType::CONSTEXPR) {
+      throw std::invalid_argument(fmt::format("Argument {} is a constexpr, it cannot be a pointer", idx));
+    }
+    void *p_item = const_cast<void *>(item);
     this->buf.push_arg(p_item);
-    const char *dtype = to_triton_typename(item.scalar_type());
 
-    const char *specialization = "";
+    Spec specialization = Spec::NONE;
     if (ssig.at(idx) == ArgType::SPECIALIZED) {
-      specialization = spec(reinterpret_cast<std::uintptr_t>(p_item));
+      specialization = spec_of(reinterpret_cast<std::uintptr_t>(p_item));
+      if (specialization != Spec::DIV16 && ssig.assumes_aligned(idx)) {
+        throw std::invalid_argument(
+            fmt::format("Argument {} is assumed to be 16-byte aligned by the specialization policy", idx));
+      }
     }
-    std::string sig_for_idx = fmt::format("*{}{}", dtype, specialization);
-    signature.push_back(sig_for_idx);
+    signature.push_pointer(dtype, specialization);
   }
 
   template <typename T>
   void handle_constexpr(const T &item) {
-    signature.push_back(fmt::format("{}", item));
+    signature.push_constexpr(item);
   }
 
   template <typename T>
   void handle_specialized(const T &item) {
-    const char *dtype = triton_type<decltype(item)>::name;
+    using U = triton_type<decltype(item)>;
     if constexpr (std::is_integral_v<std::remove_cv_t<std::remove_reference_t<decltype(item)>>>) {
-      const char *specialization = spec(item);
-      if (specialization != ":1") {
+      Spec specialization = spec_of(item);
+      if (specialization == Spec::ONE && ssig.never_one(idx)) {
+        specialization = Spec::NONE;
+      }
+      if (specialization != Spec::ONE) {
         this->buf.push_arg(item);
       }
-      std::string sig_for_idx = fmt::format("{}{}", dtype, specialization);
-      signature.push_back(sig_for_idx);
+      push_typed(U::type, U::is_pointer, specialization);
     } else {
       this->buf.push_arg(item);
-      std::string sig_for_idx = fmt::format("{}", dtype);
-      signature.push_back(sig_for_idx);
+      push_typed(U::type, U::is_pointer, Spec::NONE);
     }
   }
 
   template <typename T>
   void handle_non_constexpr(const T &item) {
+    using U = triton_type<decltype(item)>;
     this->buf.push_arg(item);
-    const char *dtype = triton_type<decltype(item)>::name;
-    signature.push_back(dtype);
+    push_typed(U::type, U::is_pointer, Spec::NONE);
+  }
+
+  void push_typed(TritonType dtype, bool is_pointer, Spec specialization) {
+    if (is_pointer) {
+      signature.push_pointer(dtype, specialization);
+    } else {
+      signature.push_scalar(dtype, specialization);
+    }
   }
 
   void append_scratch() {
-    void *global_scratch = nullptr;
-    this->buf.push_arg(global_scratch);
-#ifdef TRITON_GE_3P5
-    void *profile_scratch = nullptr;
-    this->buf.push_arg(profile_scratch);
-#endif
+    for (int i = 0; i < NUM_SCRATCH_ARGS; i++) {
+      void *scratch = nullptr;
+      this->buf.push_arg(scratch);
+    }
   }
 };
 
@@ -256,22 +592,23 @@ struct ArgHandle {
  * fixed part: stream, grid, compile options;
  * variadic part: arguments to the triton function.ArgHandle
  *
- * TODO:
- * customization point: compile options for different backends may be different.
+ * Pointers are passed as DevicePtrs, or as types with an ArgAdapter, e.g. at::Tensor with
+ * triton_jit/torch_adapter.h; scalars as C++ arithmetic values. Compile options specific to a
+ * backend are in CompileOptions::backend.
  */
 template <typename... Args>
 void TritonJITFunction::operator()(CUstream stream,
                                    unsigned int grid_x,
                                    unsigned int grid_y,
                                    unsigned int grid_z,
-                                   unsigned int num_warps,
-                                   unsigned int num_stages,
+                                   const CompileOptions &options,
                                    Args... args) const {
   const int num_args = this->static_sig_.num_args;
 
-  ParameterBuffer buffer;
-  buffer.reserve(num_args);  // this is a coarse estimation of parameter size
-  c10::SmallVector<std::string> signature;
+  // storage of the arguments is reused across launches on this thread
+  ScopedParameterBuffer scoped_buffer(num_args);
+  ParameterBuffer &buffer = scoped_buffer.get();
+  SignatureKey signature;
   signature.reserve(num_args);
 
   ArgHandle handler = {this->static_sig_, buffer, signature, 0};
@@ -279,16 +616,346 @@ void TritonJITFunction::operator()(CUstream stream,
 
   // global scratch: introduced in triton 3.3
   handler.append_scratch();
-  std::string full_signature = join_sig(signature);
 
-  // TODO: use torch backend-agnostic device APIs
-  ensure_cuda_context();
-  CUdevice device_index;
-  checkCudaErrors(cuCtxGetDevice(&device_index));
-  const TritonKernel &kernel = this->get_kernel(full_signature, num_warps, num_stages, device_index);
-  c10::SmallVector<void *> ptrs = buffer.get_ptrs();
-  kernel.launch(grid_x, grid_y, grid_z, num_warps, stream, ptrs.data());
+  CUdevice device_index = Driver::get().stream_device(stream);
+  ScopedKernelUse use(*this);
+  const TritonKernel &kernel = this->get_kernel(signature, options, device_index);
+  if (this->packed_launch_.load(std::memory_order_relaxed)) {
+    kernel.launch_packed(
+        grid_x, grid_y, grid_z, options.num_warps, device_index, stream, buffer.data(), buffer.bytes());
+  } else {
+    kernel.launch(grid_x, grid_y, grid_z, options.num_warps, device_index, stream, buffer.ptrs());
+  }
   return;
 }
-static_assert(std::is_move_constructible_v<TritonJITFunction>);
+
+template <typename... Args>
+void TritonJITFunction::launch_many(CUstream stream,
+                                    const CompileOptions &options,
+                                    const std::vector<LaunchItem<Args...>> &items) const {
+  if (items.empty()) {
+    return;
+  }
+  const int num_args = this->static_sig_.num_args;
+  ScopedParameterBuffer scoped_buffer(items.size() * (num_args + ParameterBuffer::NUM_SCRATCH));
+  ParameterBuffer &buffer = scoped_buffer.get();
+  CUdevice device_index = Driver::get().stream_device(stream);
+  ScopedKernelUse use(*this);
+
+  // where the arguments of each item are in the buffer, and its kernel
+  struct Packed {
+    size_t first;
+    size_t start;
+    size_t end;
+    const TritonKernel *kernel;
+  };
+  SmallVector<Packed, 16> packed;
+  packed.reserve(items.size());
+  SignatureKey last_signature;
+  const TritonKernel *last_kernel = nullptr;
+  size_t reused = 0;
+  for (const LaunchItem<Args...> &item : items) {
+    size_t first = buffer.next_launch();
+    SignatureKey signature;
+    signature.reserve(num_args);
+    ArgHandle handler = {this->static_sig_, buffer, signature, 0};
+    std::apply([&handler](const auto &...args) { (handler.handle_arg(args), ...); }, item.args);
+    handler.append_scratch();
+
+    const TritonKernel *kernel = nullptr;
+    if (last_kernel && signature == last_signature) {
+      kernel = last_kernel;
+      reused++;
+    } else {
+      kernel = &this->get_kernel(signature, options, device_index);
+      last_signature = std::move(signature);
+    }
+    last_kernel = kernel;
+    packed.push_back(Packed {first, buffer.offset(first), buffer.bytes(), kernel});
+  }
+  if (reused) {
+    this->cache_hits_.add(reused);
+  }
+
+  // the buffer is complete, so pointers into it are stable
+  bool packed_launch = this->packed_launch_.load(std::memory_order_relaxed);
+  void **ptrs = packed_launch ? nullptr : buffer.ptrs();
+  std::byte *data = static_cast<std::byte *>(buffer.data());
+  SmallVector<TritonKernel::BatchedLaunch, 16> launches;
+  launches.resize(items.size());
+  for (size_t i = 0; i < items.size(); i++) {
+    const LaunchItem<Args...> &item = items[i];
+    TritonKernel::BatchedLaunch &launch = launches[i];
+    launch.grid[0] = item.grid_x;
+    launch.grid[1] = item.grid_y;
+    launch.grid[2] = item.grid_z;
+    launch.args = packed_launch ? nullptr : ptrs + packed[i].first;
+    launch.params = data + packed[i].start;
+    launch.params_size = packed[i].end - packed[i].start;
+  }
+  // launches are issued in order, a run of the same kernel at once
+  for (size_t begin = 0; begin < items.size();) {
+    size_t end = begin + 1;
+    while (end < items.size() && packed[end].kernel == packed[begin].kernel) {
+      end++;
+    }
+    packed[begin].kernel->launch_many(
+        launches.data() + begin, end - begin, options.num_warps, device_index, stream);
+    begin = end;
+  }
+}
+
+/**
+ * @brief A launcher of a TritonJITFunction bound to the compile options and argument types of a
+ * callsite, see TritonJITFunction::bind.
+ *
+ * The number of arguments, and that tensors are not passed as constexprs, are checked once on
+ * bind, when the kind of each argument is captured, too. A call packs the arguments while
+ * comparing them with the signature of the last kernel it launched, without building a signature
+ * of its own: only the words that may differ between calls of the bound types are compared, i.e.
+ * those of pointers, specialized scalars, constexprs and adapted or optional arguments. On a
+ * match, the kernel is launched without looking up the kernel cache of the function; otherwise
+ * the arguments are handled as by operator(). It is thread-safe, so it may be a static local of
+ * the callsite. The kernel is remembered per device, in one of MAX_ENTRIES slots indexed by the
+ * device. An eviction from the kernel cache of the function invalidates the remembered kernels;
+ * the next call looks its kernel up again and replaces the entry of its slot. Replaced entries are
+ * retired via the function, like evicted kernels.
+ */
+template <typename... Args>
+class BoundLauncher {
+ public:
+  static constexpr size_t MAX_ENTRIES = 8;
+
+  BoundLauncher(const BoundLauncher &) = delete;
+  BoundLauncher &operator=(const BoundLauncher &) = delete;
+  ~BoundLauncher() {
+    for (std::atomic<const CacheEntry *> &slot : this->cache_) {
+      delete slot.load(std::memory_order_relaxed);
+    }
+  }
+
+  void operator()(CUstream stream,
+                  unsigned int grid_x,
+                  unsigned int grid_y,
+                  unsigned int grid_z,
+                  const Args &...args) const {
+    ScopedParameterBuffer scoped_buffer(sizeof...(Args));
+    ParameterBuffer &buffer = scoped_buffer.get();
+    CUdevice device_index = Driver::get().stream_device(stream);
+    // remembered kernels are not freed before the launch, see TritonJITFunction::ScopedKernelUse
+    TritonJITFunction::ScopedKernelUse use(this->function_);
+
+    const TritonKernel *kernel = nullptr;
+    const CacheEntry *entry = this->slot(device_index).load(std::memory_order_acquire);
+    if (entry && entry->device == device_index &&
+        entry->evictions == this->function_.evictions_.load(std::memory_order_acquire)) {
+      Matcher matcher = {*this, buffer, entry->signature, 0, true};
+      matcher.match_args(std::index_sequence_for<Args...> {}, args...);
+      if (matcher.matched && matcher.pos == entry->signature.num_words()) {
+        kernel = entry->kernel;
+        this->hits_.add();
+        this->function_.cache_hits_.add();
+        TritonJITFunction::touch(kernel);
+      } else {
+        buffer.clear();
+      }
+    }
+    if (!kernel) {
+      SignatureKey signature;
+      signature.reserve(sizeof...(Args));
+      ArgHandle handler = {this->function_.get_static_sig(), buffer, signature, 0};
+      (handler.handle_arg(args), ...);
+      kernel = this->lookup(signature, device_index);
+    }
+    for (int i = 0; i < NUM_SCRATCH_ARGS; i++) {
+      void *scratch = nullptr;
+      buffer.push_arg(scratch);
+    }
+
+    if (this->function_.packed_launch_.load(std::memory_order_relaxed)) {
+      kernel->launch_packed(grid_x,
+                            grid_y,
+                            grid_z,
+                            this->options_.num_warps,
+                            device_index,
+                            stream,
+                            buffer.data(),
+                            buffer.bytes());
+    } else {
+      kernel->launch(
+          grid_x, grid_y, grid_z, this->options_.num_warps, device_index, stream, buffer.ptrs());
+    }
+  }
+
+  int num_warps() const {
+    return this->options_.num_warps;
+  }
+  int num_stages() const {
+    return this->options_.num_stages;
+  }
+  const CompileOptions &options() const {
+    return this->options_;
+  }
+  /* launches that matched a remembered kernel, without looking up the kernel cache */
+  uint64_t cache_hits() const {
+    return this->hits_.value();
+  }
+
+ private:
+  friend class TritonJITFunction;
+
+  // entries are immutable once published. An entry lives as long as the launcher, or until it is
+  // replaced and no launch may read it any more
+  struct CacheEntry {
+    SignatureKey signature;
+    CUdevice device;
+    const TritonKernel *kernel;
+    uint64_t evictions;  // of the function when the kernel was looked up
+  };
+
+  // how an argument is handled, captured from the static signature on bind
+  struct BoundArg {
+    ArgType type;
+    bool assumes_aligned;
+    bool never_one;
+  };
+
+  /* pack the arguments while comparing them with the signature of a remembered kernel. The
+   * position of an argument in the signature depends on the arguments before it, so words are
+   * consumed even when they are not compared */
+  struct Matcher {
+    const BoundLauncher &launcher;
+    ParameterBuffer &buf;
+    const SignatureKey &expected;
+    size_t pos;
+    bool matched;
+
+    template <size_t... I>
+    void match_args(std::index_sequence<I...>, const Args &...args) {
+      (this->match_arg<I, /*fixed*/ true>(args), ...);
+    }
+
+    /* `fixed` arguments are neither optional nor adapted, so the words of non-specialized scalars
+     * are decided by their types */
+    template <size_t I, bool fixed, typename T>
+    void match_arg(const T &item) {
+      using U = std::remove_cv_t<std::remove_reference_t<T>>;
+      if constexpr (is_optional<U>::value) {
+        if (item.has_value()) {
+          this->match_arg<I, false>(item.value());
+        } else {
+          this->expect(SignatureKey::nullopt_word());
+        }
+      } else if constexpr (has_arg_adapter<U>::value) {
+        ArgAdapter<U>::apply(item, [this](const auto &v) { this->template match_arg<I, false>(v); });
+      } else if constexpr (is_device_ptr<U>::value) {
+        const BoundArg &arg = this->launcher.args_[I];
+        void *p = const_cast<void *>(static_cast<const void *>(item.get()));
+        this->buf.push_arg(p);
+        Spec specialization = Spec::NONE;
+        if (arg.type == ArgType::SPECIALIZED) {
+          specialization = spec_of(reinterpret_cast<std::uintptr_t>(p));
+          // a broken assumption is reported by ArgHandle
+          this->matched &= specialization == Spec::DIV16 || !arg.assumes_aligned;
+        }
+        this->expect(SignatureKey::pointer_word(item.dtype(), specialization));
+      } else if constexpr (std::is_same_v<std::nullopt_t, U>) {
+        this->expect(SignatureKey::nullopt_word());
+      } else {
+        using V = triton_type<U>;
+        const BoundArg &arg = this->launcher.args_[I];
+        if (arg.type == ArgType::CONSTEXPR) {
+          auto [tag_word, bits] = SignatureKey::constexpr_words(item);
+          this->expect(tag_word);
+          this->expect(bits);
+          return;
+        }
+        Spec specialization = Spec::NONE;
+        if constexpr (std::is_integral_v<U>) {
+          if (arg.type == ArgType::SPECIALIZED) {
+            specialization = spec_of(item);
+            if (specialization == Spec::ONE && arg.never_one) {
+              specialization = Spec::NONE;
+            }
+          }
+        }
+        if (specialization != Spec::ONE) {
+          this->buf.push_arg(item);
+        }
+        if (fixed && arg.type == ArgType::NON_CONSTEXPR) {
+          this->pos++;
+        } else {
+          this->expect(V::is_pointer ? SignatureKey::pointer_word(V::type, specialization)
+                                     : SignatureKey::scalar_word(V::type, specialization));
+        }
+      }
+    }
+
+    void expect(uint64_t word) {
+      this->matched &= this->pos < this->expected.num_words() && this->expected.word(this->pos) == word;
+      this->pos++;
+    }
+  };
+
+  BoundLauncher(const TritonJITFunction &function, const CompileOptions &options)
+      : function_(function), options_(options) {
+    const StaticSignature &ssig = function.get_static_sig();
+    if (static_cast<int>(sizeof...(Args)) != ssig.num_args) {
+      throw std::invalid_argument(fmt::format(
+          "{} takes {} arguments, {} are bound", function.function_name_, ssig.num_args, sizeof...(Args)));
+    }
+    constexpr bool is_pointer[] = {is_pointer_arg<Args>()..., false};
+    for (int i = 0; i < ssig.num_args; i++) {
+      if (is_pointer[i] && ssig.at(i) == ArgType::CONSTEXPR) {
+        throw std::invalid_argument(fmt::format(
+            "Argument {} of {} is a constexpr, it cannot be a pointer", i, function.function_name_));
+      }
+      this->args_[i] = BoundArg {ssig.at(i), ssig.assumes_aligned(i), ssig.never_one(i)};
+    }
+  }
+
+  /* whether arguments of type T are passed as pointers, i.e. DevicePtrs or adapted to them */
+  template <typename T>
+  static constexpr bool is_pointer_arg() {
+    if constexpr (is_device_ptr<T>::value) {
+      return true;
+    } else if constexpr (has_arg_adapter<T>::value) {
+      return ArgAdapter<T>::is_pointer;
+    } else {
+      return false;
+    }
+  }
+
+  /* get the kernel via the kernel cache of the function, and remember it */
+  const TritonKernel *lookup(const SignatureKey &signature, CUdevice device_index) const {
+    const TritonKernel *kernel =
+        &this->function_.get_kernel(signature, this->options_, device_index);
+    // counted after the miss, whose kernel may have evicted another one. The kernel is in the
+    // cache after it was counted, so a later eviction of it invalidates the entry
+    uint64_t evictions = this->function_.evictions_.load(std::memory_order_acquire);
+    // a kernel returned by tiered compilation may be a less specialized one, which is not
+    // remembered, so that the specialized one is picked up once it is compiled
+    KernelKey key {signature, this->options_, Driver::get().device_arch(device_index)};
+    if (this->function_.find_kernel(key) != kernel) {
+      return kernel;
+    }
+    const CacheEntry *replaced = this->slot(device_index)
+                                     .exchange(new CacheEntry {signature, device_index, kernel, evictions},
+                                               std::memory_order_acq_rel);
+    if (replaced) {
+      this->function_.retire(std::shared_ptr<const void>(replaced));
+    }
+    return kernel;
+  }
+
+  std::atomic<const CacheEntry *> &slot(CUdevice device_index) const {
+    return this->cache_[static_cast<size_t>(device_index) % MAX_ENTRIES];
+  }
+
+  const TritonJITFunction &function_;
+  CompileOptions options_;
+  std::array<BoundArg, sizeof...(Args)> args_;
+  mutable std::array<std::atomic<const CacheEntry *>, MAX_ENTRIES> cache_ {};
+  mutable Counter hits_;
+};
 }  // namespace triton_jit
@@ -1,11 +1,22 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
 #include <mutex>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "cuda.h"
 #include "triton_jit/jit_utils.h"
+#include "triton_jit/launch_attributes.h"
+#include "triton_jit/metrics.h"
+#include "triton_jit/module_cache.h"
+#include "triton_jit/sharded_mutex.h"
+#include "triton_jit/small_vector.h"
 
 namespace triton_jit {
 
@@ -16,15 +27,42 @@ T get_next_multiple_of(T pos, T step) {
   return ((pos + step - 1) / step) * step;
 }
 
+/**
+ * @brief Kernel arguments packed in the kernel parameter layout, i.e. each at the next multiple of
+ * its alignment.
+ *
+ * The storage is sized for the worst case on reserve and is inline for up to INLINE_ARGS
+ * arguments, so pushing an argument is a copy. The array of pointers to the arguments, which
+ * cuLaunchKernel takes, is built in place, too. Alternatively, the packed block itself can be
+ * passed via CU_LAUNCH_PARAM_BUFFER_POINTER, see TritonKernel::launch_packed.
+ */
 struct ParameterBuffer {
-  c10::SmallVector<std::byte> buff_;
+  // scalars & pointers passed to kernels take at most 8 bytes
+  static constexpr size_t MAX_ARG_SIZE = 8;
+  static constexpr size_t INLINE_ARGS = 16;
+  // global & profile scratch pointers appended after the arguments
+  static constexpr size_t NUM_SCRATCH = 2;
+
+  // its size is the capacity in use, the packed arguments take the first cursor_ bytes
+  SmallVector<std::byte, INLINE_ARGS * MAX_ARG_SIZE> buff_;
   size_t cursor_ = 0;
-  c10::SmallVector<size_t> offsets_;
+  SmallVector<size_t, INLINE_ARGS> offsets_;
+  SmallVector<void *, INLINE_ARGS> ptrs_;
 
+  /* make room for new_cap arguments and the scratch pointers */
   void reserve(size_t new_cap) {
-    const int ESTIMATED_BYTES_PER_ARG = 4;
-    this->buff_.reserve(new_cap * ESTIMATED_BYTES_PER_ARG);
+    new_cap += NUM_SCRATCH;
+    if (this->buff_.size() < new_cap * MAX_ARG_SIZE) {
+      this->buff_.resize(new_cap * MAX_ARG_SIZE);
+    }
     this->offsets_.reserve(new_cap);
+    this->ptrs_.reserve(new_cap);
+  }
+
+  /* drop the arguments, keeping the storage */
+  void clear() {
+    this->cursor_ = 0;
+    this->offsets_.clear();
   }
 
   template <typename T>
@@ -36,21 +74,50 @@ struct ParameterBuffer {
     this->offsets_.push_back(offset);
 
     size_t size = sizeof(U);
-    this->buff_.resize(offset + size);
+    if (offset + size > this->buff_.size()) {
+      this->buff_.resize(std::max(offset + size, 2 * this->buff_.size()));
+    }
     std::byte *ptr = this->buff_.data() + offset;
     std::memcpy(ptr, &v, size);
 
     this->cursor_ = offset + size;
   }
 
-  c10::SmallVector<void *> get_ptrs() {
-    c10::SmallVector<void *> ptrs;
-    ptrs.reserve(this->offsets_.size());
+  /* start the arguments of another launch after those pushed so far, at a multiple of
+   * MAX_ARG_SIZE so that they are packed in the kernel parameter layout relative to their first
+   * one, see TritonJITFunction::launch_many. Returns the index of its first argument */
+  size_t next_launch() {
+    this->cursor_ = get_next_multiple_of(this->cursor_, MAX_ARG_SIZE);
+    return this->offsets_.size();
+  }
+
+  /* offset of the i-th argument in the packed block */
+  size_t offset(size_t i) const {
+    return this->offsets_[i];
+  }
+
+  /* pointers to the arguments, valid until the next push_arg or clear */
+  void **ptrs() {
+    this->ptrs_.resize(this->offsets_.size());
     std::byte *start = this->buff_.data();
-    for (const size_t off : this->offsets_) {
-      ptrs.push_back(start + off);
+    for (size_t i = 0; i < this->offsets_.size(); i++) {
+      this->ptrs_[i] = start + this->offsets_[i];
     }
-    return ptrs;
+    return this->ptrs_.data();
+  }
+
+  /* a copy of ptrs(), kept for existing callers */
+  SmallVector<void *> get_ptrs() {
+    void **ptrs = this->ptrs();
+    return SmallVector<void *>(ptrs, ptrs + this->offsets_.size());
+  }
+
+  /* the packed arguments, and their size in bytes */
+  void *data() {
+    return this->buff_.data();
+  }
+  size_t bytes() const {
+    return this->cursor_;
   }
 
   size_t size() const {
@@ -58,7 +125,55 @@ struct ParameterBuffer {
   }
 };
 
+/**
+ * @brief A ParameterBuffer leased from a thread-local arena.
+ *
+ * Buffers are kept for later launches on the thread, so the storage of a buffer of more than
+ * INLINE_ARGS arguments is allocated once per thread instead of once per launch. The arena is a
+ * stack, so leases may nest, e.g. a launch in the benchmark of an autotuner.
+ */
+class ScopedParameterBuffer {
+ public:
+  explicit ScopedParameterBuffer(size_t num_args) {
+    Arena &arena = ScopedParameterBuffer::arena();
+    if (arena.depth == arena.buffers.size()) {
+      arena.buffers.push_back(std::make_unique<ParameterBuffer>());
+    }
+    this->buffer_ = arena.buffers[arena.depth++].get();
+    this->buffer_->clear();
+    this->buffer_->reserve(num_args);
+  }
+  ~ScopedParameterBuffer() {
+    ScopedParameterBuffer::arena().depth--;
+  }
+  ScopedParameterBuffer(const ScopedParameterBuffer &) = delete;
+  ScopedParameterBuffer &operator=(const ScopedParameterBuffer &) = delete;
+
+  ParameterBuffer &get() {
+    return *this->buffer_;
+  }
+
+ private:
+  struct Arena {
+    std::vector<std::unique_ptr<ParameterBuffer>> buffers;
+    size_t depth = 0;
+  };
+  static Arena &arena() {
+    thread_local Arena arena;
+    return arena;
+  }
+
+  ParameterBuffer *buffer_;
+};
+
+/**
+ * @brief A kernel compiled for a cuda arch, which is loaded into each device of the arch it is
+ * launched on.
+ */
 class TritonKernel {
+ public:
+  static constexpr int MAX_DEVICES = 32;
+
  private:
   // * The directory that contain the IRs(ttir, ttgir, llir, ptx, cubin) & metadata(json file))*/
   std::string dir_;
@@ -66,30 +181,99 @@ class TritonKernel {
   std::string kernel_name_;
   unsigned int shared_; /* amount of static shared memory per block (in bytes) required for the cubin*/
   unsigned int arch_;   /* cuda arch */
+  /* clusters, cooperative grid & pdl the kernel is compiled for */
+  LaunchAttributes attributes_;
+  /* the cubin in memory, embedded in the binary or mapped from dir_ on the first load, guarded by
+   * load_mutex_ */
+  mutable std::shared_ptr<const CubinImage> cubin_;
+
+  /* the kernel loaded into a device, filled on the first launch on the device. Modules are shared
+   * with kernels of the same cubin, see ModuleTable */
+  struct DeviceHandle {
+    CUmodule mod = nullptr;
+    // published with release semantics after mod is set, guarded by load_mutex_
+    std::atomic<CUfunction> fn {nullptr};
+  };
+  mutable std::array<DeviceHandle, MAX_DEVICES> handles_;
+  mutable std::mutex load_mutex_;
 
-  mutable CUmodule mod_;
-  mutable CUfunction fn_;
-  mutable bool loaded_ = false;
+  // metrics, see TritonJITFunction::metrics
+  mutable Counter launches_;
+  mutable Histogram load_time_;
+
+  // tick of the LRU clock of TritonJITFunction when the kernel was last used
+  mutable std::atomic<uint64_t> last_used_ {0};
+  // launches between getting the function of a device and handing it to the driver, sharded per
+  // thread; the kernel is unloaded only when none is in flight, see unload
+  struct alignas(64) InFlight {
+    std::atomic<int64_t> count {0};
+  };
+  mutable std::array<InFlight, ShardedSharedMutex::NUM_SHARDS> in_flight_;
+  struct InFlightGuard {
+    std::atomic<int64_t> &count;
+    explicit InFlightGuard(const TritonKernel &kernel)
+        : count(kernel.in_flight_[thread_shard_index() % ShardedSharedMutex::NUM_SHARDS].count) {
+      this->count.fetch_add(1, std::memory_order_seq_cst);
+    }
+    ~InFlightGuard() {
+      this->count.fetch_sub(1, std::memory_order_release);
+    }
+  };
 
  public:
   TritonKernel(const TritonKernel &) = delete;
   TritonKernel &operator=(const TritonKernel &) = delete;
-  TritonKernel(TritonKernel &&) = default;
-  TritonKernel &operator=(TritonKernel &&) = default;
-  TritonKernel() = default;
+  TritonKernel(TritonKernel &&) = delete;
+  TritonKernel &operator=(TritonKernel &&) = delete;
 
+  /* launch on the device of the stream, which the caller got from Driver::stream_device, so
+   * the context of the stream is current */
   void launch(unsigned int grid_x,
               unsigned int grid_y,
               unsigned int grid_z,
               int num_warps,
+              CUdevice device_index,
               CUstream stream,
               void **args) const;
+  /* launch with the arguments packed in one block, via CU_LAUNCH_PARAM_BUFFER_POINTER */
+  void launch_packed(unsigned int grid_x,
+                     unsigned int grid_y,
+                     unsigned int grid_z,
+                     int num_warps,
+                     CUdevice device_index,
+                     CUstream stream,
+                     void *params,
+                     size_t params_size) const;
+
+  /* a launch of launch_many: the grid, and the arguments as in launch, or packed as in
+   * launch_packed if args is nullptr */
+  struct BatchedLaunch {
+    unsigned int grid[3];
+    void **args;
+    void *params;
+    size_t params_size;
+  };
+  /* launch the kernel once per item, in order. The kernel is loaded once for all of them */
+  void launch_many(const BatchedLaunch *items,
+                   size_t num_items,
+                   int num_warps,
+                   CUdevice device_index,
+                   CUstream stream) const;
+
+  const LaunchAttributes &launch_attributes() const {
+    return this->attributes_;
+  }
   friend TritonJITFunction;
 
  private:
   TritonKernel(std::string_view dir, std::string_view kernel_name);
-  /* load cubin into a cumodule for a device */
-  void lazy_init_handle() const;
+  /* a kernel whose metadata & cubin image are in memory, the image should outlive the kernel */
+  TritonKernel(std::string_view kernel_name, std::string_view metadata, const void *image, size_t image_size);
+  /* the kernel in the device, loading the cubin into it on the first call; it is thread-safe */
+  CUfunction lazy_init_handle(CUdevice device_index) const;
+  /* release the modules of the kernel in all devices, and the cubin if it is mapped from a file,
+   * unless a launch is in flight, in which case it returns false and should be retried. A launch
+   * after that loads the kernel again */
+  bool unload() const;
 };
-static_assert(std::is_move_constructible_v<TritonKernel>);
 }  // namespace triton_jit
@@ -0,0 +1,60 @@
+import json
+import os
+import sys
+import traceback
+from argparse import ArgumentParser
+
+DESC = """
+A compile worker process of libtriton_jit.
+
+It serves requests over a unix socket inherited from the library at file descriptor `fd`. Each
+request and response is a line of json. Requests are
+
+{"type": "signature", "file": ..., "function": ...}
+{"type": "autotune", "file": ..., "function": ...}
+{"type": "kernel", "file": ..., "function": ..., "signature": ..., "num_warps": ..., "num_stages": ...,
+ "options": {...}, "arch": ...}
+
+and responses are {"ok": true, "result": ...} or {"ok": false, "error": ...}. The worker exits when
+the socket is closed.
+"""
+
+
+def serve(fd: int):
+    # anything printed by the compiler must not interleave with the responses
+    os.dup2(sys.stderr.fileno(), sys.stdout.fileno())
+    # imported after the redirection, since importing them may print
+    from compiler_session import session
+
+    with os.fdopen(fd, "rb") as rfile, os.fdopen(os.dup(fd), "wb", buffering=0) as wfile:
+        for line in rfile:
+            try:
+                request = json.loads(line)
+                if request["type"] == "signature":
+                    result = session.extract_static_signature(request["file"], request["function"])
+                elif request["type"] == "autotune":
+                    result = session.extract_autotune_configs(request["file"], request["function"])
+                elif request["type"] == "kernel":
+                    result = session.compile_a_kernel(
+                        request["file"],
+                        request["function"],
+                        request["signature"],
+                        request["num_warps"],
+                        request["num_stages"],
+                        target_arch=request["arch"],
+                        options=request.get("options"),
+                    )
+                else:
+                    raise ValueError(f"unknown request type {request['type']}")
+                response = {"ok": True, "result": result}
+            except Exception as e:  # noqa: BLE001, report any error to the library
+                traceback.print_exc()
+                response = {"ok": False, "error": f"{type(e).__name__}: {e}"}
+            wfile.write((json.dumps(response) + "\n").encode())
+
+
+if __name__ == "__main__":
+    parser = ArgumentParser(description=DESC)
+    parser.add_argument("--fd", type=int, required=True, help="file descriptor of the socket")
+    args = parser.parse_args()
+    serve(args.fd)
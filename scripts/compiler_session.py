@@ -0,0 +1,121 @@
+import hashlib
+import importlib.util
+import os
+import threading
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Tuple
+
+import triton
+
+from gen_ssig import arg_types_of
+from standalone_compile import _compile_a_kernel
+
+DESC = """
+A long-lived compiler session for the embedded interpreter of libtriton_jit.
+
+Loading a jit function executes the file that defines it, which may dominate the time of a
+compile when triton's cache is warm. The session keeps the loaded modules and the unwrapped
+JITFunctions, and reloads a module only when its source file changes. A change is detected by the
+file's mtime & size first, then confirmed by the hash of its content, so that touching a file does
+not trigger a reload.
+"""
+
+
+@dataclass
+class _Entry:
+    mtime_ns: int
+    size: int
+    digest: str
+    obj: object  # the object as defined, e.g. an Autotuner wrapping the JITFunction
+    fn: triton.runtime.JITFunction
+
+
+def _unwrap(fn) -> triton.runtime.JITFunction:
+    # unwrap JITFunction from Autotuner or Heuristics, contarct: decorated fn is stored in the fn attribute
+    while not (type(fn) is triton.runtime.JITFunction):
+        fn = fn.fn
+    return fn
+
+
+class CompilerSession:
+    def __init__(self):
+        self._entries: Dict[Tuple[str, str], _Entry] = {}
+        # the GIL may be released during compilation, so guard the entries
+        self._lock = threading.Lock()
+
+    def get_function(self, source_path, fn_name: str) -> triton.runtime.JITFunction:
+        """the JITFunction `fn_name` defined in the file, the file is executed only if it changed"""
+        return self._load(source_path, fn_name).fn
+
+    def _load(self, source_path, fn_name: str) -> _Entry:
+        source_path = Path(source_path).resolve()
+        key = (str(source_path), fn_name)
+        st = os.stat(source_path)
+        with self._lock:
+            entry = self._entries.get(key)
+            if entry and entry.mtime_ns == st.st_mtime_ns and entry.size == st.st_size:
+                return entry
+
+            content = source_path.read_bytes()
+            digest = hashlib.sha256(content).hexdigest()
+            if entry and entry.digest == digest:
+                entry.mtime_ns, entry.size = st.st_mtime_ns, st.st_size
+                return entry
+
+            spec = importlib.util.spec_from_file_location(source_path.stem, source_path)
+            mod = importlib.util.module_from_spec(spec)
+            spec.loader.exec_module(mod)
+            obj = getattr(mod, fn_name)
+            entry = _Entry(st.st_mtime_ns, st.st_size, digest, obj, _unwrap(obj))
+            self._entries[key] = entry
+            return entry
+
+    def extract_static_signature(self, source_path, fn_name: str) -> List[int]:
+        return arg_types_of(self.get_function(source_path, fn_name))
+
+    def extract_autotune_configs(self, source_path, fn_name: str) -> Optional[Dict]:
+        """configs & key of the Autotuner that wraps the function, None if it is not autotuned.
+
+        Arguments are referred to by their indices. Configs are in the form of
+        {"constexprs": [[index, value], ...], "num_warps": ..., "num_stages": ...}.
+        """
+        entry = self._load(source_path, fn_name)
+        tuner = entry.obj
+        while not isinstance(tuner, triton.runtime.Autotuner):
+            if type(tuner) is triton.runtime.JITFunction:
+                return None
+            tuner = tuner.fn
+
+        arg_names = entry.fn.arg_names
+        configs = []
+        for config in tuner.configs:
+            constexprs = [[arg_names.index(k), v] for k, v in config.kwargs.items()]
+            configs.append(
+                {
+                    "constexprs": sorted(constexprs),
+                    "num_warps": config.num_warps,
+                    "num_stages": config.num_stages,
+                }
+            )
+        return {"key": [arg_names.index(k) for k in tuner.keys], "configs": configs}
+
+    def compile_a_kernel(
+        self,
+        source_path,
+        fn_name: str,
+        signature: str,
+        num_warps: int = 4,
+        num_stages: int = 3,
+        device_id: int = 0,
+        target_arch: Optional[int] = None,
+        options: Optional[Dict[str, Any]] = None,
+    ) -> str:
+        fn = self.get_function(source_path, fn_name)
+        return _compile_a_kernel(
+            fn, signature, num_warps, num_stages, device_id, target_arch, options
+        )
+
+
+# the session of this interpreter
+session = CompilerSession()
@@ -0,0 +1,263 @@
+from argparse import ArgumentParser
+from pathlib import Path
+from typing import List
+
+import triton
+from packaging.version import Version
+
+from gen_ssig import extract_static_signature
+from standalone_compile import compile_a_kernel, ty_to_cpp
+
+triton_version = Version(triton.__version__)
+# fmt: off
+SCALAR_TYPES = [
+    "i1", "i8", "i16", "i32", "i64", "u1", "u8", "u16", "u32", "u64", "fp16", "bf16", "fp32", "f32", "fp64"
+]
+# fmt: on
+
+DESC = """
+Script to compile a Triton Jit function at build time and embed the compiled kernels into C++ sources.
+
+It compiles the function with name `kernel-name` in the file at the provided `path` for each
+signature and each cuda arch, then it generates a source file that embeds the cubins & metadata
+and registers them to triton_jit's EmbeddedKernelRegistry, and a header that declares a launch
+stub for each signature. It is driven by the cmake function `triton_jit_add_kernels`.
+
+Compiling for a given arch does not require a gpu, but requires triton to be installed.
+"""
+
+
+def c_bytes(data: bytes, indent: str = "    ") -> str:
+    """format bytes as the body of a C array initializer"""
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append(indent + ", ".join(f"0x{b:02x}" for b in data[i : i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def c_string(text: str) -> str:
+    """format text as a C string literal, non-printable characters are octal escaped"""
+    out = []
+    for b in text.encode("utf-8"):
+        c = chr(b)
+        if c == "\\" or c == '"':
+            out.append("\\" + c)
+        elif 0x20 <= b < 0x7F:
+            out.append(c)
+        else:
+            out.append(f"\\{b:03o}")
+    return '"' + "".join(out) + '"'
+
+
+def stub_params(signature: str) -> List[str]:
+    """parameters of the launch stub, the arguments that are not compiled into the kernel.
+
+    The stub does not check the specializations, e.g. pointers declared as `:16` must be 16-byte aligned.
+    """
+    params = []
+    for i, s in enumerate(s.strip() for s in signature.split(",")):
+        ty, _, hint = s.partition(":")
+        if hint.strip() == "1":  # equal to 1, specialized as a constant
+            continue
+        if ty[0] == "*":
+            params.append(f"CUdeviceptr arg{i}")
+        elif ty in SCALAR_TYPES:
+            params.append(f"{ty_to_cpp(ty)} arg{i}")
+        # the rest are constexprs or nullopt, which are not passed to the kernel
+    return params
+
+
+def scratch_args() -> List[str]:
+    """scratch pointers appended to the arguments, the same as ArgHandle does.
+
+    Triton < 3.3 takes no global scratch, the pointer is ignored by the launch. The number is
+    checked against triton_jit::NUM_SCRATCH_ARGS when the generated source is compiled, since
+    triton_jit may be built for another version of triton.
+    """
+    scratch = ["global_scratch"]
+    if triton_version >= Version("3.5.0"):
+        scratch.append("profile_scratch")
+    return scratch
+
+
+def source_hash(source_path: Path) -> int:
+    """FNV-1a hash of the source, the same as KernelIndex::hash_file"""
+    h = 0xCBF29CE484222325
+    for b in source_path.read_bytes():
+        h ^= b
+        h = (h * 0x100000001B3) & 0xFFFFFFFFFFFFFFFF
+    return h
+
+
+def embed_kernels(
+    source_path: Path,
+    fn_name: str,
+    signatures: List[str],
+    num_warps: int,
+    num_stages: int,
+    archs: List[int],
+    out_source: Path,
+    out_header: Path,
+):
+    source_path = source_path.resolve()
+    file_name = source_path.name
+    hash_literal = f"0x{source_hash(source_path):016x}ULL"
+    arg_types = extract_static_signature(source_path, fn_name)
+
+    kernel_defs = []
+    kernel_entries = []
+    for i, signature in enumerate(signatures):
+        for arch in archs:
+            kernel_dir = Path(
+                compile_a_kernel(
+                    source_path, fn_name, signature, num_warps, num_stages, target_arch=arch
+                )
+            )
+            cubin = (kernel_dir / f"{fn_name}.cubin").read_bytes()
+            metadata = (kernel_dir / f"{fn_name}.json").read_text()
+            name = f"{fn_name}_{i}_sm{arch}"
+            kernel_defs.append(
+                f"alignas(8) const unsigned char {name}_cubin[] = {{\n{c_bytes(cubin)}\n}};\n"
+                f"const char {name}_metadata[] = {c_string(metadata)};\n"
+            )
+            kernel_entries.append(
+                f"    {{{c_string(file_name)}, {c_string(fn_name)}, {hash_literal}, {c_string(signature)}, "
+                f"{num_warps}, {num_stages}, {arch}, {name}_cubin, sizeof({name}_cubin), "
+                f"{name}_metadata}},"
+            )
+
+    stub_decls = []
+    stub_defs = []
+    for i, signature in enumerate(signatures):
+        params = ", ".join(
+            [
+                "CUstream stream",
+                "unsigned int grid_x",
+                "unsigned int grid_y",
+                "unsigned int grid_z",
+            ]
+            + stub_params(signature)
+        )
+        args = [p.split()[-1] for p in stub_params(signature)] + scratch_args()
+        decl = f"void {fn_name}_{i}({params})"
+        stub_decls.append(f"/* signature: {signature} */\n{decl};\n")
+        scratch_decls = "".join(f"  void *{s} = nullptr;\n" for s in scratch_args())
+        stub_defs.append(
+            f"{decl} {{\n"
+            f"  static const triton_jit::TritonJITFunction &f =\n"
+            f"      triton_jit::TritonJITFunction::get_instance({c_string(str(source_path))}, "
+            f"{c_string(fn_name)});\n"
+            f"  static const triton_jit::SignatureKey signature =\n"
+            f"      triton_jit::SignatureKey::from_signature({c_string(signature)});\n"
+            f"  CUdevice device_index = triton_jit::Driver::get().stream_device(stream);\n"
+            f"  triton_jit::TritonJITFunction::ScopedKernelUse use(f);\n"
+            f"  const triton_jit::TritonKernel &kernel =\n"
+            f"      f.get_kernel(signature, {num_warps}, {num_stages}, device_index);\n"
+            f"{scratch_decls}"
+            f"  void *args[] = {{{', '.join('&' + a for a in args)}}};\n"
+            f"  kernel.launch(grid_x, grid_y, grid_z, {num_warps}, device_index, stream, args);\n"
+            f"}}\n"
+        )
+
+    arg_type_list = ", ".join(str(t) for t in arg_types)
+    source = f"""// generated by embed_kernels.py from {file_name}, do not edit
+#include "{out_header.name}"
+
+#include "triton_jit/embedded_kernels.h"
+#include "triton_jit/triton_jit_function.h"
+
+namespace {{
+const int {fn_name}_arg_types[] = {{{arg_type_list}}};
+const triton_jit::EmbeddedFunction {fn_name}_function = {{
+    {c_string(file_name)}, {c_string(fn_name)}, {hash_literal}, {fn_name}_arg_types, {len(arg_types)}}};
+
+static_assert(triton_jit::NUM_SCRATCH_ARGS == {len(scratch_args())},
+              "the kernels are compiled by triton {triton_version}, but triton_jit is built for another "
+              "version of triton, which takes another number of scratch pointers");
+
+{"".join(kernel_defs)}
+const triton_jit::EmbeddedKernel {fn_name}_kernels[] = {{
+{chr(10).join(kernel_entries)}
+}};
+
+struct Registrar {{
+  Registrar() {{
+    triton_jit::EmbeddedKernelRegistry &registry = triton_jit::EmbeddedKernelRegistry::get();
+    registry.add_function({fn_name}_function);
+    for (const triton_jit::EmbeddedKernel &kernel : {fn_name}_kernels) {{
+      registry.add_kernel(kernel);
+    }}
+  }}
+}} registrar;
+}}  // namespace
+
+namespace triton_jit_kernels {{
+{chr(10).join(stub_defs)}
+}}  // namespace triton_jit_kernels
+"""
+
+    header = f"""// generated by embed_kernels.py from {file_name}, do not edit
+#pragma once
+
+#include <cstdint>
+#include "cuda.h"
+
+namespace triton_jit_kernels {{
+{chr(10).join(stub_decls)}
+}}  // namespace triton_jit_kernels
+"""
+    out_source.parent.mkdir(parents=True, exist_ok=True)
+    out_header.parent.mkdir(parents=True, exist_ok=True)
+    out_source.write_text(source)
+    out_header.write_text(header)
+
+
+if __name__ == "__main__":
+    parser = ArgumentParser(description=DESC)
+    parser.add_argument(
+        "path",
+        type=Path,
+        help="Path to Python source containing desired kernel in its scope. File will be executed.",
+    )
+    parser.add_argument(
+        "--kernel-name", "-n", type=str, help="Name of the kernel to compile", required=True
+    )
+    parser.add_argument(
+        "--signature",
+        "-s",
+        type=str,
+        action="append",
+        help="Signature of the kernel, can be repeated",
+        required=True,
+    )
+    parser.add_argument(
+        "--num-warps", "-w", type=int, default=4, help="Number of warps to launch the kernel"
+    )
+    parser.add_argument(
+        "--num-stages",
+        "-ns",
+        type=int,
+        default=3,
+        help="Number of stages (meta-parameter of the kernel)",
+    )
+    parser.add_argument(
+        "--arch",
+        type=int,
+        action="append",
+        help="Cuda arch to compile for, e.g. 80 for sm_80, can be repeated",
+        required=True,
+    )
+    parser.add_argument("--out-source", type=Path, help="Generated source file", required=True)
+    parser.add_argument("--out-header", type=Path, help="Generated header file", required=True)
+    args = parser.parse_args()
+
+    embed_kernels(
+        Path(args.path).expanduser(),
+        args.kernel_name,
+        args.signature,
+        args.num_warps,
+        args.num_stages,
+        args.arch,
+        args.out_source,
+        args.out_header,
+    )
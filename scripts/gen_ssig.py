@@ -40,7 +40,10 @@ def extract_static_signature(source_path, fn_name):
     # unwrap JITFunction from Autotuner or Heuristics, contarct: decorated fn is stored in the fn attribute
     while not (type(fn) is triton.runtime.JITFunction):
         fn = fn.fn
+    return arg_types_of(fn)
 
+
+def arg_types_of(fn: triton.runtime.JITFunction):
     sig = static_signature(fn)
 
     # convert to list of int for c++ processing
@@ -1,7 +1,7 @@
 import importlib.util
 from argparse import ArgumentParser
 from pathlib import Path
-from typing import List, Tuple, Union
+from typing import Any, Dict, List, Optional, Tuple, Union
 
 import torch
 import triton
@@ -104,8 +104,16 @@ def _compile_a_kernel(
     num_warps: int = 4,
     num_stages: int = 3,
     device_id: int = 0,
+    target_arch: Optional[int] = None,
+    options: Optional[Dict[str, Any]] = None,
 ) -> Tuple[str, str]:
-    """compile a kernel."""
+    """compile a kernel.
+
+    If target_arch is given, compile for that cuda arch instead of the one of the device, which
+    does not require a gpu, e.g. at build time. options are the compile options besides num_warps
+    and num_stages, e.g. {"maxnreg": 128, "debug": False}; those unknown to the backend are ignored
+    by triton.
+    """
     # static signature
     constexpr_indices = [i for (i, p) in enumerate(fn.params) if p.is_constexpr]
     # non_constexpr_indices = [i for (i, p) in enumerate(fn.params) if not p.is_constexpr]
@@ -226,15 +234,24 @@ def _compile_a_kernel(
 
     # STEP2: compile options for the backend
     opts = {"num_warps": num_warps, "num_stages": num_stages}
+    if options:
+        opts.update(options)
 
-    with torch.cuda.device(device_id):
+    if target_arch is not None:
         # STEP3: ast source, target, compile options
-        target: triton.backends.compiler.GPUTarget = (
-            triton.runtime.driver.active.get_current_target()
-        )
+        target = triton.backends.compiler.GPUTarget("cuda", target_arch, 32)
         ccinfo: triton.compiler.CompiledKernel = triton.compile(
             src, target, options=opts
         )
+    else:
+        with torch.cuda.device(device_id):
+            # STEP3: ast source, target, compile options
+            target: triton.backends.compiler.GPUTarget = (
+                triton.runtime.driver.active.get_current_target()
+            )
+            ccinfo: triton.compiler.CompiledKernel = triton.compile(
+                src, target, options=opts
+            )
 
     # kernel's hash may not equals the dir in cache
     from triton.runtime.cache import get_cache_manager
@@ -250,6 +267,8 @@ def compile_a_kernel(
     num_warps: int = 4,
     num_stages: int = 3,
     device_id: int = 0,
+    target_arch: Optional[int] = None,
+    options: Optional[Dict[str, Any]] = None,
 ):
     # get jit function
     source_path = Path(source_path)
@@ -262,7 +281,7 @@ def compile_a_kernel(
     while not (type(fn) is triton.runtime.JITFunction):
         fn = fn.fn
 
-    return _compile_a_kernel(fn, signature, num_warps, num_stages, device_id)
+    return _compile_a_kernel(fn, signature, num_warps, num_stages, device_id, target_arch, options)
 
 
 if __name__ == "__main__":
@@ -305,11 +324,23 @@ if __name__ == "__main__":
     parser.add_argument(
         "--signature", "-s", type=str, help="Signature of the kernel", required=True
     )
+    parser.add_argument(
+        "--arch",
+        type=int,
+        default=None,
+        help="Cuda arch to compile for, e.g. 80 for sm_80, instead of the device's",
+    )
     args = parser.parse_args()
 
     # execute python sources and extract functions wrapped in JITFunction
     arg_path = Path(args.path).expanduser()
     kerel_hash = compile_a_kernel(
-        arg_path, args.kernel_name, args.signature, args.num_warps, args.num_stages
+        arg_path,
+        args.kernel_name,
+        args.signature,
+        args.num_warps,
+        args.num_stages,
+        args.device_id,
+        args.arch,
     )
     print(kerel_hash)
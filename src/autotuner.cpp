@@ -0,0 +1,226 @@
+#include "triton_jit/autotuner.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <set>
+
+#include "nlohmann/json.hpp"
+#include "triton_jit/kernel_index.h"
+#include "triton_jit/logging.h"
+
+using json = nlohmann::json;
+
+namespace triton_jit {
+
+namespace {
+json config_to_json(const AutotuneConfig &config) {
+  json constexprs = json::array();
+  for (const auto &[index, value] : config.constexprs) {
+    std::visit([&](auto v) { constexprs.push_back(json::array({index, v})); }, value);
+  }
+  return {{"constexprs", constexprs}, {"num_warps", config.num_warps}, {"num_stages", config.num_stages}};
+}
+
+AutotuneConfig config_from_json(const json &j) {
+  AutotuneConfig config;
+  for (const json &item : j["constexprs"]) {
+    int index = item[0].get<int>();
+    const json &v = item[1];
+    if (v.is_boolean()) {
+      config.constexprs.emplace_back(index, v.get<bool>());
+    } else if (v.is_number_integer()) {
+      config.constexprs.emplace_back(index, v.get<int64_t>());
+    } else if (v.is_number_float()) {
+      config.constexprs.emplace_back(index, v.get<double>());
+    } else {
+      throw std::invalid_argument(fmt::format("Unsupported value of a config: {}", v.dump()));
+    }
+  }
+  std::sort(config.constexprs.begin(), config.constexprs.end(), [](const auto &a, const auto &b) {
+    return a.first < b.first;
+  });
+  config.num_warps = j["num_warps"].get<int>();
+  config.num_stages = j["num_stages"].get<int>();
+  return config;
+}
+}  // namespace
+
+const AutotuneConfig::Value *AutotuneConfig::find(int index) const {
+  for (const auto &item : this->constexprs) {
+    if (item.first == index) {
+      return &item.second;
+    }
+  }
+  return nullptr;
+}
+
+std::string AutotuneConfig::to_string() const {
+  return config_to_json(*this).dump();
+}
+
+AutotuneCache::AutotuneCache(std::string id,
+                             std::vector<AutotuneConfig> configs,
+                             std::optional<std::filesystem::path> path)
+    : id_(std::move(id)), configs_(std::move(configs)), path_(std::move(path)) {
+  if (this->configs_.empty()) {
+    throw std::invalid_argument("An autotuner needs at least one config");
+  }
+  if (this->path_) {
+    this->load();
+  }
+}
+
+void AutotuneCache::load() {
+  std::ifstream f(*this->path_);
+  std::string line;
+  while (std::getline(f, line)) {
+    json record = json::parse(line, nullptr, /*allow_exceptions*/ false);
+    if (record.is_discarded() || !record.is_object()) {
+      continue;
+    }
+    try {
+      if (record["id"].get<std::string>() != this->id_) {
+        continue;
+      }
+      AutotuneConfig config = config_from_json(record["config"]);
+      auto pos = std::find(this->configs_.begin(), this->configs_.end(), config);
+      if (pos != this->configs_.end()) {
+        this->best_[record["key"].get<std::string>()] = pos - this->configs_.begin();
+      }
+    } catch (const std::exception &e) {
+      TRITON_JIT_LOG(WARNING) << fmt::format("Skipping a malformed record in the autotune cache: {}",
+                                             e.what());
+    }
+  }
+}
+
+void AutotuneCache::append(const std::string &key, const AutotuneConfig &config) {
+  json record = {{"id", this->id_}, {"key", key}, {"config", config_to_json(config)}};
+  std::string data = record.dump() + "\n";
+  // a single write with O_APPEND, so that records of concurrent processes do not interleave
+  int fd = ::open(this->path_->c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+  if (fd < 0) {
+    TRITON_JIT_LOG(WARNING) << fmt::format("Cannot open the autotune cache {}", this->path_->string());
+    return;
+  }
+  if (::write(fd, data.data(), data.size()) != static_cast<ssize_t>(data.size())) {
+    TRITON_JIT_LOG(WARNING) << fmt::format("Cannot write to the autotune cache {}", this->path_->string());
+  }
+  ::close(fd);
+}
+
+const AutotuneConfig &AutotuneCache::select(const std::string &key,
+                                            const std::function<double(const AutotuneConfig &)> &benchmark) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  auto pos = this->best_.find(key);
+  if (pos != this->best_.end()) {
+    return this->configs_[pos->second];
+  }
+
+  size_t best = 0;
+  double best_time = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < this->configs_.size(); i++) {
+    double t;
+    try {
+      t = benchmark(this->configs_[i]);
+    } catch (const std::exception &e) {
+      TRITON_JIT_LOG(WARNING) << fmt::format(
+          "Skipping config {}: {}", this->configs_[i].to_string(), e.what());
+      continue;
+    }
+    TRITON_JIT_LOG(INFO) << fmt::format("Autotuning {} key {}: config {} takes {} ms",
+                                        this->id_,
+                                        key,
+                                        this->configs_[i].to_string(),
+                                        t);
+    if (t < best_time) {
+      best = i;
+      best_time = t;
+    }
+  }
+  if (best_time == std::numeric_limits<double>::infinity()) {
+    throw std::runtime_error(fmt::format("No config of {} works for key {}", this->id_, key));
+  }
+  this->best_[key] = best;
+  if (this->path_) {
+    this->append(key, this->configs_[best]);
+  }
+  return this->configs_[best];
+}
+
+double cuda_event_timer(CUstream stream, const AutotuneConfig &config, const std::function<void()> &launch) {
+  const int NUM_REPEATS = 10;
+  launch();  // warmup, which compiles the kernel, too
+  CUevent start, end;
+  checkCudaErrors(cuEventCreate(&start, CU_EVENT_DEFAULT));
+  checkCudaErrors(cuEventCreate(&end, CU_EVENT_DEFAULT));
+  checkCudaErrors(cuEventRecord(start, stream));
+  for (int i = 0; i < NUM_REPEATS; i++) {
+    launch();
+  }
+  checkCudaErrors(cuEventRecord(end, stream));
+  checkCudaErrors(cuEventSynchronize(end));
+  float ms = 0;
+  checkCudaErrors(cuEventElapsedTime(&ms, start, end));
+  checkCudaErrors(cuEventDestroy(start));
+  checkCudaErrors(cuEventDestroy(end));
+  return ms / NUM_REPEATS;
+}
+
+std::unordered_map<std::string, std::unique_ptr<TritonAutotuner>> TritonAutotuner::tuners_;
+std::mutex TritonAutotuner::tuners_mutex_;
+
+TritonAutotuner::TritonAutotuner(std::string_view path, std::string_view name)
+    : function_(TritonJITFunction::get_instance(path, name)) {
+  json info = json::parse(this->function_.extract_autotune_configs());
+  if (info.is_null()) {
+    throw std::invalid_argument(fmt::format("{} in {} is not autotuned", name, path));
+  }
+  std::vector<AutotuneConfig> configs;
+  for (const json &item : info["configs"]) {
+    configs.push_back(config_from_json(item));
+  }
+  if (configs.empty()) {
+    throw std::invalid_argument(fmt::format("{} in {} has no configs", name, path));
+  }
+
+  // configs set the same arguments, the rest are passed to the call
+  std::set<int> config_args;
+  for (const auto &item : configs.front().constexprs) {
+    config_args.insert(item.first);
+  }
+  std::set<int> key_args;
+  for (const json &index : info["key"]) {
+    key_args.insert(index.get<int>());
+  }
+  for (int i = 0; i < this->function_.get_static_sig().num_args; i++) {
+    if (!config_args.count(i)) {
+      this->is_key_.push_back(key_args.count(i) > 0);
+    }
+  }
+
+  std::optional<std::filesystem::path> cache_path;
+  std::optional<uint64_t> source_hash = this->function_.source_hash();
+  KernelIndex &index = KernelIndex::get();
+  if (source_hash && index.enabled()) {
+    cache_path = index.directory() / "autotune.jsonl";
+  }
+  std::string id = fmt::format(
+      "{}|{}|{:016x}", this->function_.source_path(), name, source_hash ? *source_hash : uint64_t(0));
+  this->cache_ = std::make_unique<AutotuneCache>(id, std::move(configs), cache_path);
+}
+
+TritonAutotuner &TritonAutotuner::get_instance(std::string_view path, std::string_view name) {
+  std::string key = fmt::format("{}:{}", path, name);
+  std::lock_guard<std::mutex> lock(tuners_mutex_);
+  auto pos = tuners_.find(key);
+  if (pos == tuners_.end()) {
+    pos = tuners_.emplace(key, std::unique_ptr<TritonAutotuner>(new TritonAutotuner(path, name))).first;
+  }
+  return *pos->second;
+}
+
+}  // namespace triton_jit
@@ -0,0 +1,50 @@
+#include "triton_jit/compile_options.h"
+
+#include <type_traits>
+
+#include "fmt/core.h"
+
+namespace triton_jit {
+
+std::vector<std::pair<std::string, CompileOptions::Value>> CompileOptions::items() const {
+  const CompileOptions defaults;
+  std::vector<std::pair<std::string, Value>> items;
+  items.reserve(6 + this->backend.size());
+  items.emplace_back("num_warps", int64_t(this->num_warps));
+  items.emplace_back("num_stages", int64_t(this->num_stages));
+  if (this->num_ctas != defaults.num_ctas) {
+    items.emplace_back("num_ctas", int64_t(this->num_ctas));
+  }
+  if (this->maxnreg != defaults.maxnreg) {
+    items.emplace_back("maxnreg", int64_t(this->maxnreg));
+  }
+  if (this->enable_fp_fusion != defaults.enable_fp_fusion) {
+    items.emplace_back("enable_fp_fusion", this->enable_fp_fusion);
+  }
+  if (this->launch_pdl != defaults.launch_pdl) {
+    items.emplace_back("launch_pdl", this->launch_pdl);
+  }
+  for (const auto &[name, value] : this->backend) {
+    items.emplace_back(name, value);
+  }
+  return items;
+}
+
+std::string CompileOptions::to_string() const {
+  std::string out;
+  for (const auto &[name, value] : this->items()) {
+    std::string rendered = std::visit(
+        [](const auto &v) -> std::string {
+          if constexpr (std::is_same_v<std::decay_t<decltype(v)>, bool>) {
+            return v ? "true" : "false";
+          } else {
+            return fmt::format("{}", v);
+          }
+        },
+        value);
+    out += fmt::format("{}{}={}", out.empty() ? "" : ";", name, rendered);
+  }
+  return out;
+}
+
+}  // namespace triton_jit
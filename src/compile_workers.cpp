@@ -0,0 +1,232 @@
+#include "triton_jit/compile_workers.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <variant>
+
+#include "fmt/core.h"
+#include "nlohmann/json.hpp"
+#include "triton_jit/jit_utils.h"
+#include "triton_jit/logging.h"
+
+using json = nlohmann::json;
+
+extern char **environ;
+
+namespace triton_jit {
+
+CompileWorkerPool::CompileWorkerPool(int num_workers,
+                                     std::chrono::milliseconds timeout,
+                                     std::string python_executable)
+    : timeout_(timeout), python_executable_(std::move(python_executable)), workers_(num_workers) {
+}
+
+CompileWorkerPool::~CompileWorkerPool() {
+  for (Worker &worker : this->workers_) {
+    this->kill(worker);
+  }
+}
+
+CompileWorkerPool *CompileWorkerPool::get() {
+  static CompileWorkerPool *pool = []() -> CompileWorkerPool * {
+    const char *num_workers = std::getenv("TRITON_JIT_COMPILE_WORKERS");
+    if (!num_workers || std::atoi(num_workers) <= 0) {
+      return nullptr;
+    }
+    std::chrono::milliseconds timeout = std::chrono::seconds(600);
+    if (const char *env = std::getenv("TRITON_JIT_COMPILE_TIMEOUT")) {
+      timeout = std::chrono::milliseconds(static_cast<int64_t>(std::atof(env) * 1000));
+    }
+    const char *python = std::getenv("TRITON_JIT_PYTHON");
+    // leaked on purpose, workers exit when the process exits and closes their sockets
+    return new CompileWorkerPool(
+        std::atoi(num_workers), timeout, python ? python : TRITON_JIT_PYTHON_EXECUTABLE);
+  }();
+  return pool;
+}
+
+std::vector<int> CompileWorkerPool::extract_static_signature(const std::string &file,
+                                                             const std::string &function) {
+  json request = {{"type", "signature"}, {"file", file}, {"function", function}};
+  return json::parse(this->request(request.dump())).get<std::vector<int>>();
+}
+
+std::string CompileWorkerPool::extract_autotune_configs(const std::string &file,
+                                                        const std::string &function) {
+  json request = {{"type", "autotune"}, {"file", file}, {"function", function}};
+  return this->request(request.dump());
+}
+
+std::string CompileWorkerPool::compile_kernel(const std::string &file,
+                                              const std::string &function,
+                                              const std::string &signature,
+                                              const CompileOptions &options,
+                                              unsigned int arch) {
+  // the options other than num_warps & num_stages are passed as they are to triton.compile
+  json extra_options = json::object();
+  for (const auto &[name, value] : options.items()) {
+    if (name != "num_warps" && name != "num_stages") {
+      extra_options[name] = std::visit([](const auto &v) { return json(v); }, value);
+    }
+  }
+  json request = {{"type", "kernel"},
+                  {"file", file},
+                  {"function", function},
+                  {"signature", signature},
+                  {"num_warps", options.num_warps},
+                  {"num_stages", options.num_stages},
+                  {"options", extra_options},
+                  {"arch", arch}};
+  return json::parse(this->request(request.dump())).get<std::string>();
+}
+
+std::string CompileWorkerPool::request(const std::string &line) {
+  Worker *worker = nullptr;
+  {
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    auto idle = [this]() {
+      return std::find_if(this->workers_.begin(), this->workers_.end(), [](const Worker &w) {
+        return !w.busy;
+      });
+    };
+    this->cv_.wait(lock, [&]() { return idle() != this->workers_.end(); });
+    worker = &*idle();
+    worker->busy = true;
+  }
+  // release the worker whatever happens, a failed one is respawned by the next request
+  struct Release {
+    CompileWorkerPool *pool;
+    Worker *worker;
+    ~Release() {
+      {
+        std::lock_guard<std::mutex> lock(pool->mutex_);
+        worker->busy = false;
+      }
+      pool->cv_.notify_one();
+    }
+  } release {this, worker};
+
+  if (worker->pid < 0) {
+    this->spawn(*worker);
+  }
+  std::string data = line + "\n";
+  // MSG_NOSIGNAL: a dead worker must not raise SIGPIPE in this process
+  if (::send(worker->fd, data.data(), data.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(data.size())) {
+    this->kill(*worker);
+    throw CompileWorkerError("Failed to send a request to the compile worker");
+  }
+
+  std::string response_line;
+  if (!this->read_line(*worker, std::chrono::steady_clock::now() + this->timeout_, response_line)) {
+    this->kill(*worker);
+    throw CompileWorkerError(fmt::format("The compile worker crashed or timed out on request {}", line));
+  }
+  json response = json::parse(response_line);
+  if (!response["ok"].get<bool>()) {
+    throw std::runtime_error(response["error"].get<std::string>());
+  }
+  return response["result"].dump();
+}
+
+void CompileWorkerPool::spawn(Worker &worker) {
+  int fds[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+    throw CompileWorkerError(fmt::format("Failed to create a socket pair: {}", std::strerror(errno)));
+  }
+  std::string script = (get_script_dir() / "compile_worker.py").string();
+  const int WORKER_FD = 3;
+  std::string fd_arg = std::to_string(WORKER_FD);
+  std::vector<char *> argv = {const_cast<char *>(this->python_executable_.c_str()),
+                              const_cast<char *>(script.c_str()),
+                              const_cast<char *>("--fd"),
+                              const_cast<char *>(fd_arg.c_str()),
+                              nullptr};
+  // dup2 to itself would keep close-on-exec, so the socket is moved off the worker's fd first
+  if (fds[1] == WORKER_FD) {
+    int moved = ::fcntl(fds[1], F_DUPFD_CLOEXEC, WORKER_FD + 1);
+    ::close(fds[1]);
+    if (moved < 0) {
+      ::close(fds[0]);
+      throw CompileWorkerError(fmt::format("Failed to move the worker socket: {}", std::strerror(errno)));
+    }
+    fds[1] = moved;
+  }
+
+  // posix_spawn rather than fork & exec, the process is multithreaded. The interpreter is found at
+  // build time, so it is an absolute path unless TRITON_JIT_PYTHON names one on the PATH
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fds[1], WORKER_FD);
+  pid_t pid = -1;
+  int err = std::strchr(argv[0], '/')
+                ? ::posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ)
+                : ::posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (err != 0) {
+    ::close(fds[0]);
+    ::close(fds[1]);
+    throw CompileWorkerError(fmt::format("Failed to spawn a compile worker: {}", std::strerror(err)));
+  }
+  ::close(fds[1]);
+  worker.pid = pid;
+  worker.fd = fds[0];
+  TRITON_JIT_LOG(INFO) << fmt::format("Spawned compile worker {}", pid);
+}
+
+void CompileWorkerPool::kill(Worker &worker) {
+  if (worker.fd >= 0) {
+    ::close(worker.fd);
+    worker.fd = -1;
+  }
+  if (worker.pid > 0) {
+    ::kill(worker.pid, SIGKILL);
+    ::waitpid(worker.pid, nullptr, 0);
+    worker.pid = -1;
+  }
+}
+
+bool CompileWorkerPool::read_line(Worker &worker,
+                                  std::chrono::steady_clock::time_point deadline,
+                                  std::string &line) {
+  line.clear();
+  char buf[4096];
+  while (true) {
+    auto remaining =
+        std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    if (remaining.count() <= 0) {
+      return false;
+    }
+    pollfd pfd {worker.fd, POLLIN, 0};
+    int ready = ::poll(&pfd, 1, static_cast<int>(std::min<int64_t>(remaining.count(), INT32_MAX)));
+    if (ready < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ready <= 0) {
+      return false;
+    }
+    ssize_t n = ::recv(worker.fd, buf, sizeof(buf), 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    line.append(buf, n);
+    if (line.back() == '\n') {
+      line.pop_back();
+      return true;
+    }
+  }
+}
+
+}  // namespace triton_jit
@@ -0,0 +1,327 @@
+#include "triton_jit/driver.h"
+
+#include <cstdlib>
+#include <stdexcept>
+
+#include "fmt/core.h"
+#include "triton_jit/jit_utils.h"
+#include "triton_jit/logging.h"
+
+namespace triton_jit {
+
+std::atomic<Driver *> Driver::active_ {nullptr};
+
+Driver &Driver::default_driver() {
+  // leaked on purpose, kernels may be launched during static destruction
+  static Driver *driver = []() -> Driver * {
+    const char *env = std::getenv("TRITON_JIT_DRIVER");
+    if (env && std::string(env) == "null") {
+      TRITON_JIT_LOG(INFO) << "Using the null driver, kernels are not executed";
+      return new NullDriver();
+    }
+    return new CudaDriver();
+  }();
+  return *driver;
+}
+
+namespace {
+// The launch context of this thread: the context last seen current by a launch, and its device.
+// Launches look it up instead of querying the driver for the device, unless the context changes.
+struct LaunchContext {
+  CUcontext ctx = nullptr;
+  CUdevice device = -1;
+};
+thread_local LaunchContext launch_context;
+
+// the null streams are in the current context
+bool is_null_stream(CUstream stream) {
+  return stream == nullptr || stream == CU_STREAM_LEGACY || stream == CU_STREAM_PER_THREAD;
+}
+}  // namespace
+
+CUdevice CudaDriver::current_device() {
+  CUcontext ctx;
+  checkCudaErrors(cuCtxGetCurrent(&ctx));
+  LaunchContext &lc = launch_context;
+  if (ctx && ctx == lc.ctx) {
+    return lc.device;
+  }
+  if (!ctx) {
+    ensure_cuda_context();
+    checkCudaErrors(cuCtxGetCurrent(&ctx));
+  }
+  lc.ctx = ctx;
+  checkCudaErrors(cuCtxGetDevice(&lc.device));
+  return lc.device;
+}
+
+CUdevice CudaDriver::stream_device(CUstream stream) {
+  if (is_null_stream(stream)) {
+    return this->current_device();
+  }
+  CUcontext ctx, current;
+  checkCudaErrors(cuStreamGetCtx(stream, &ctx));
+  checkCudaErrors(cuCtxGetCurrent(&current));
+  LaunchContext &lc = launch_context;
+  if (ctx == current && ctx == lc.ctx) {
+    return lc.device;
+  }
+  if (ctx != current) {
+    checkCudaErrors(cuCtxSetCurrent(ctx));
+  }
+  lc.ctx = ctx;
+  checkCudaErrors(cuCtxGetDevice(&lc.device));
+  return lc.device;
+}
+
+unsigned int CudaDriver::device_arch(CUdevice device) {
+  // it is looked up on every launch, to find the kernel of the arch
+  if (device < 0 || device >= MAX_CACHED_DEVICES) {
+    return get_device_arch(device);
+  }
+  unsigned int arch = this->archs_[device].load(std::memory_order_relaxed);
+  if (arch == 0) {
+    arch = get_device_arch(device);
+    this->archs_[device].store(arch, std::memory_order_relaxed);
+  }
+  return arch;
+}
+
+CUmodule CudaDriver::load_module(CUdevice device, const void *image) {
+  CUmodule module;
+  checkCudaErrors(cuModuleLoadData(&module, image));
+  CUcontext context;
+  checkCudaErrors(cuCtxGetCurrent(&context));
+  std::lock_guard<std::mutex> lock(this->modules_mutex_);
+  this->module_contexts_[module] = context;
+  return module;
+}
+
+void CudaDriver::unload_module(CUdevice device, CUmodule module) {
+  CUcontext context;
+  {
+    std::lock_guard<std::mutex> lock(this->modules_mutex_);
+    auto pos = this->module_contexts_.find(module);
+    if (pos == this->module_contexts_.end()) {
+      throw std::runtime_error(fmt::format("Module {} is not loaded", reinterpret_cast<void *>(module)));
+    }
+    context = pos->second;
+    this->module_contexts_.erase(pos);
+  }
+  // the calling thread may be on another context
+  checkCudaErrors(cuCtxPushCurrent(context));
+  CUresult result = cuModuleUnload(module);
+  checkCudaErrors(cuCtxPopCurrent(&context));
+  checkCudaErrors(result);
+}
+
+CUfunction CudaDriver::get_function(CUdevice device,
+                                    CUmodule module,
+                                    const std::string &kernel_name,
+                                    unsigned int shared) {
+  // get function
+  CUfunction function;
+  checkCudaErrors(cuModuleGetFunction(&function, module, kernel_name.c_str()));
+
+  // check required shared memory does not exceeds max shared memory per block
+  int shared_optin;
+  cuDeviceGetAttribute(&shared_optin, CU_DEVICE_ATTRIBUTE_MAX_SHARED_MEMORY_PER_BLOCK_OPTIN, device);
+  if (shared > shared_optin) {
+    throw std::runtime_error(
+        fmt::format("Out0fResources: Requested shared memory ({}) bytes exceeds GPU's maximum ({}) bytes.",
+                    shared,
+                    shared_optin));
+  }
+
+  // increase shared memory if required
+  if (shared > 49152 && shared_optin > 49152) {
+    TRITON_JIT_LOG(INFO) << fmt::format(
+        "Condition met: this->shared_ ={} && shared_optin = {}. Setting CU_FUNC_CACHE_PREFER_SHARED.",
+        shared,
+        shared_optin);
+    checkCudaErrors(cuFuncSetCacheConfig(function, CU_FUNC_CACHE_PREFER_SHARED));
+    int shared_total, shared_static;
+    checkCudaErrors(cuDeviceGetAttribute(
+        &shared_total, CU_DEVICE_ATTRIBUTE_MAX_SHARED_MEMORY_PER_MULTIPROCESSOR, device));
+    checkCudaErrors(cuFuncGetAttribute(&shared_static, CU_FUNC_ATTRIBUTE_SHARED_SIZE_BYTES, function));
+    TRITON_JIT_LOG(INFO) << fmt::format("current shared memory total {}", shared_total);
+    TRITON_JIT_LOG(INFO) << fmt::format("current shared memory static {}", shared_static);
+    checkCudaErrors(cuFuncSetAttribute(function,
+                                       CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES,
+                                       shared_optin - shared_static));
+    TRITON_JIT_LOG(INFO) << fmt::format("shared memory to add {}", shared_optin - shared_static);
+  }
+  return function;
+}
+
+void CudaDriver::launch(CUfunction function,
+                        unsigned int grid_x,
+                        unsigned int grid_y,
+                        unsigned int grid_z,
+                        unsigned int block_x,
+                        unsigned int shared,
+                        CUstream stream,
+                        void **args) {
+  checkCudaErrors(cuLaunchKernel(function,
+                                 /*grid*/ grid_x,
+                                 grid_y,
+                                 grid_z,
+                                 /*block*/ block_x,
+                                 1,
+                                 1,
+                                 /*shared & stream*/ shared,
+                                 /*stream*/ stream,
+                                 /*args*/ args,
+                                 nullptr));
+}
+
+void CudaDriver::launch_packed(CUfunction function,
+                               unsigned int grid_x,
+                               unsigned int grid_y,
+                               unsigned int grid_z,
+                               unsigned int block_x,
+                               unsigned int shared,
+                               CUstream stream,
+                               void *params,
+                               size_t params_size) {
+  void *config[] = {CU_LAUNCH_PARAM_BUFFER_POINTER,
+                    params,
+                    CU_LAUNCH_PARAM_BUFFER_SIZE,
+                    &params_size,
+                    CU_LAUNCH_PARAM_END};
+  checkCudaErrors(cuLaunchKernel(function,
+                                 /*grid*/ grid_x,
+                                 grid_y,
+                                 grid_z,
+                                 /*block*/ block_x,
+                                 1,
+                                 1,
+                                 /*shared & stream*/ shared,
+                                 /*stream*/ stream,
+                                 /*args*/ nullptr,
+                                 config));
+}
+
+void CudaDriver::launch_with_attributes(CUfunction function,
+                                        unsigned int grid_x,
+                                        unsigned int grid_y,
+                                        unsigned int grid_z,
+                                        unsigned int block_x,
+                                        unsigned int shared,
+                                        CUstream stream,
+                                        void **args,
+                                        void *params,
+                                        size_t params_size,
+                                        const LaunchAttributes &attributes) {
+  CUlaunchAttribute attrs[LaunchAttributes::MAX_ATTRIBUTES];
+  std::array<unsigned int, 3> grid = attributes.grid_dims(grid_x, grid_y, grid_z);
+  CUlaunchConfig config = {};
+  config.gridDimX = grid[0];
+  config.gridDimY = grid[1];
+  config.gridDimZ = grid[2];
+  config.blockDimX = block_x;
+  config.blockDimY = 1;
+  config.blockDimZ = 1;
+  config.sharedMemBytes = shared;
+  config.hStream = stream;
+  config.attrs = attrs;
+  config.numAttrs = attributes.fill(attrs);
+  if (args) {
+    checkCudaErrors(cuLaunchKernelEx(&config, function, args, nullptr));
+  } else {
+    void *extra[] = {CU_LAUNCH_PARAM_BUFFER_POINTER,
+                     params,
+                     CU_LAUNCH_PARAM_BUFFER_SIZE,
+                     &params_size,
+                     CU_LAUNCH_PARAM_END};
+    checkCudaErrors(cuLaunchKernelEx(&config, function, nullptr, extra));
+  }
+}
+
+NullDriver::~NullDriver() = default;
+
+CUmodule NullDriver::load_module(CUdevice device, const void *image) {
+  uint64_t n = this->num_loads_.fetch_add(1, std::memory_order_relaxed) + 1;
+  return reinterpret_cast<CUmodule>(static_cast<uintptr_t>(n));
+}
+
+CUfunction NullDriver::get_function(CUdevice device,
+                                    CUmodule module,
+                                    const std::string &kernel_name,
+                                    unsigned int shared) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->functions_.push_back(std::make_unique<std::string>(kernel_name));
+  return reinterpret_cast<CUfunction>(this->functions_.back().get());
+}
+
+void NullDriver::launch(CUfunction function,
+                        unsigned int grid_x,
+                        unsigned int grid_y,
+                        unsigned int grid_z,
+                        unsigned int block_x,
+                        unsigned int shared,
+                        CUstream stream,
+                        void **args) {
+  this->num_launches_.fetch_add(1, std::memory_order_relaxed);
+  if (this->recording_.load(std::memory_order_relaxed)) {
+    this->record(function, {grid_x, grid_y, grid_z}, block_x, shared, stream, 0);
+  }
+}
+
+void NullDriver::launch_packed(CUfunction function,
+                               unsigned int grid_x,
+                               unsigned int grid_y,
+                               unsigned int grid_z,
+                               unsigned int block_x,
+                               unsigned int shared,
+                               CUstream stream,
+                               void *params,
+                               size_t params_size) {
+  this->num_launches_.fetch_add(1, std::memory_order_relaxed);
+  if (this->recording_.load(std::memory_order_relaxed)) {
+    this->record(function, {grid_x, grid_y, grid_z}, block_x, shared, stream, params_size);
+  }
+}
+
+void NullDriver::launch_with_attributes(CUfunction function,
+                                        unsigned int grid_x,
+                                        unsigned int grid_y,
+                                        unsigned int grid_z,
+                                        unsigned int block_x,
+                                        unsigned int shared,
+                                        CUstream stream,
+                                        void **args,
+                                        void *params,
+                                        size_t params_size,
+                                        const LaunchAttributes &attributes) {
+  this->num_launches_.fetch_add(1, std::memory_order_relaxed);
+  if (this->recording_.load(std::memory_order_relaxed)) {
+    this->record(
+        function, {grid_x, grid_y, grid_z}, block_x, shared, stream, args ? 0 : params_size, attributes);
+  }
+}
+
+void NullDriver::record(CUfunction function,
+                        std::array<unsigned int, 3> grid,
+                        unsigned int block_x,
+                        unsigned int shared,
+                        CUstream stream,
+                        size_t params_size,
+                        const LaunchAttributes &attributes) {
+  const std::string &kernel_name = *reinterpret_cast<const std::string *>(function);
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->launches_.push_back({kernel_name, grid, block_x, shared, stream, params_size, attributes});
+}
+
+std::vector<NullDriver::LaunchRecord> NullDriver::launches() const {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->launches_;
+}
+
+void NullDriver::clear() {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->launches_.clear();
+  this->num_launches_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace triton_jit
@@ -0,0 +1,115 @@
+#include "triton_jit/embedded_kernels.h"
+
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+
+#include "fmt/core.h"
+#include "triton_jit/compile_options.h"
+#include "triton_jit/kernel_index.h"
+#include "triton_jit/logging.h"
+#include "triton_jit/signature_key.h"
+
+namespace triton_jit {
+
+namespace {
+std::string file_name(std::string_view file) {
+  return std::filesystem::path(file).filename().string();
+}
+
+std::string function_key(std::string_view file, std::string_view function) {
+  return fmt::format("{}|{}", file_name(file), function);
+}
+
+// the signature is rendered from its binary form, so that spellings differing in whitespace or
+// in the form of constexpr values match
+std::string kernel_key(std::string_view file,
+                       std::string_view function,
+                       uint64_t source_hash,
+                       std::string_view signature,
+                       std::string_view options,
+                       unsigned int arch) {
+  return fmt::format("{}|{:016x}|{}|{}|{}",
+                     function_key(file, function),
+                     source_hash,
+                     SignatureKey::from_signature(signature).to_signature(),
+                     options,
+                     arch);
+}
+}  // namespace
+
+EmbeddedKernelRegistry &EmbeddedKernelRegistry::get() {
+  static EmbeddedKernelRegistry registry;
+  return registry;
+}
+
+void EmbeddedKernelRegistry::add_function(const EmbeddedFunction &function) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  std::vector<const EmbeddedFunction *> &functions =
+      this->functions_[function_key(function.file, function.function)];
+  for (const EmbeddedFunction *&registered : functions) {
+    if (registered->source_hash == function.source_hash) {
+      registered = &function;
+      return;
+    }
+  }
+  functions.push_back(&function);
+}
+
+void EmbeddedKernelRegistry::add_kernel(const EmbeddedKernel &kernel) {
+  std::string options = CompileOptions(kernel.num_warps, kernel.num_stages).to_string();
+  std::string key =
+      kernel_key(kernel.file, kernel.function, kernel.source_hash, kernel.signature, options, kernel.arch);
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->kernels_[key] = &kernel;
+}
+
+const EmbeddedFunction *EmbeddedKernelRegistry::find_function(std::string_view path,
+                                                              std::string_view function) const {
+  std::vector<const EmbeddedFunction *> functions;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    auto pos = this->functions_.find(function_key(path, function));
+    if (pos == this->functions_.end()) {
+      return nullptr;
+    }
+    functions = pos->second;
+  }
+  std::optional<uint64_t> source_hash;
+  try {
+    source_hash = KernelIndex::hash_file(std::string(path));
+  } catch (const std::runtime_error &e) {
+    // the source is not deployed with the embedded kernels
+  }
+  if (!source_hash) {
+    if (functions.size() > 1) {
+      throw std::runtime_error(fmt::format(
+          "{} of {} is embedded from {} different sources, deploy the source to tell them apart",
+          function,
+          file_name(path),
+          functions.size()));
+    }
+    return functions.front();
+  }
+  for (const EmbeddedFunction *embedded : functions) {
+    if (embedded->source_hash == *source_hash) {
+      return embedded;
+    }
+  }
+  TRITON_JIT_LOG(WARNING) << fmt::format(
+      "{} is embedded from another version of {}, its embedded kernels are not used", function, path);
+  return nullptr;
+}
+
+const EmbeddedKernel *EmbeddedKernelRegistry::find_kernel(const EmbeddedFunction &function,
+                                                          std::string_view signature,
+                                                          std::string_view options,
+                                                          unsigned int arch) const {
+  std::string key =
+      kernel_key(function.file, function.function, function.source_hash, signature, options, arch);
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  auto pos = this->kernels_.find(key);
+  return pos == this->kernels_.end() ? nullptr : pos->second;
+}
+
+}  // namespace triton_jit
@@ -6,6 +6,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 
@@ -25,6 +26,10 @@ std::filesystem::path get_path_of_this_library() {
   return cached_path;
 }
 
+const char* get_triton_version() {
+  return TRITON_JIT_TRITON_VERSION;
+}
+
 std::filesystem::path get_script_dir() {
   const static std::filesystem::path script_dir = []() {
     std::filesystem::path installed_script_dir =
@@ -63,14 +68,32 @@ std::filesystem::path get_home_directory() {
   return home_dir;
 }
 
+const bool verbose_logging = []() {
+  const char* env = std::getenv("TRITON_JIT_VERBOSE");
+  return env && std::string(env) == "1";
+}();
+
 void ensure_cuda_context() {
   CUcontext pctx;
   checkCudaErrors(cuCtxGetCurrent(&pctx));
   if (!pctx) {
+    static std::once_flag warned;
+    std::call_once(warned, []() {
+      TRITON_JIT_LOG(WARNING)
+          << "No CUDA context is current, using the primary context of device 0. Launch on a stream of the "
+             "device, or make its context current, on multi-gpu machines";
+    });
     CUdevice device_index;
     checkCudaErrors(cuDeviceGet(&device_index, /*ordinal*/ 0));
     checkCudaErrors(cuDevicePrimaryCtxRetain(&pctx, device_index));
     checkCudaErrors(cuCtxSetCurrent(pctx));
   }
 }
+
+unsigned int get_device_arch(CUdevice device_index) {
+  int major = 0, minor = 0;
+  checkCudaErrors(cuDeviceGetAttribute(&major, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR, device_index));
+  checkCudaErrors(cuDeviceGetAttribute(&minor, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR, device_index));
+  return major * 10 + minor;
+}
 }  // namespace triton_jit
@@ -0,0 +1,250 @@
+#include "triton_jit/kernel_index.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "fmt/core.h"
+#include "nlohmann/json.hpp"
+#include "triton_jit/jit_utils.h"
+#include "triton_jit/logging.h"
+
+using json = nlohmann::json;
+
+namespace triton_jit {
+
+namespace {
+std::string function_key(const std::string &file, const std::string &function, uint64_t source_hash) {
+  return fmt::format("{}|{}|{:016x}", file, function, source_hash);
+}
+
+// kernels of another triton version or argument layout are not launched by this build of the library
+std::string kernel_key(const std::string &file,
+                       const std::string &function,
+                       uint64_t source_hash,
+                       const std::string &signature,
+                       const std::string &options,
+                       unsigned int arch,
+                       const std::string &triton_version,
+                       int num_scratch_args) {
+  return fmt::format("{}|{}|{:016x}|{}|{}|{}|{}|{}",
+                     file,
+                     function,
+                     source_hash,
+                     signature,
+                     options,
+                     arch,
+                     triton_version,
+                     num_scratch_args);
+}
+
+std::string current_kernel_key(const std::string &file,
+                               const std::string &function,
+                               uint64_t source_hash,
+                               const std::string &signature,
+                               const std::string &options,
+                               unsigned int arch) {
+  return kernel_key(
+      file, function, source_hash, signature, options, arch, get_triton_version(), NUM_SCRATCH_ARGS);
+}
+}  // namespace
+
+KernelIndex &KernelIndex::get() {
+  static KernelIndex index;
+  return index;
+}
+
+KernelIndex::KernelIndex() {
+  const char *disable = std::getenv("TRITON_JIT_DISABLE_INDEX");
+  if (disable && std::string(disable) == "1") {
+    this->enabled_ = false;
+    return;
+  }
+  const char *dir = std::getenv("TRITON_JIT_CACHE_DIR");
+  if (!dir && !std::getenv("HOME")) {
+    this->enabled_ = false;
+    return;
+  }
+  std::filesystem::path index_dir =
+      dir ? std::filesystem::path(dir) : get_home_directory() / ".triton" / "libtriton_jit";
+  this->path_ = index_dir / "index.jsonl";
+  std::error_code ec;
+  std::filesystem::create_directories(index_dir, ec);
+  if (ec) {
+    TRITON_JIT_LOG(WARNING) << fmt::format(
+        "Cannot create the kernel index dir {}: {}", index_dir.string(), ec.message());
+    this->enabled_ = false;
+    return;
+  }
+  this->load();
+}
+
+void KernelIndex::load() {
+  std::ifstream f(this->path_);
+  std::string line;
+  while (std::getline(f, line)) {
+    // a line may be truncated if a process died while appending it, skip it
+    json record = json::parse(line, nullptr, /*allow_exceptions*/ false);
+    if (record.is_discarded() || !record.is_object()) {
+      continue;
+    }
+    try {
+      const std::string type = record["type"].get<std::string>();
+      const std::string file = record["file"].get<std::string>();
+      const std::string function = record["function"].get<std::string>();
+      const uint64_t source_hash = record["source_hash"].get<uint64_t>();
+      if (type == "function") {
+        this->static_signatures_[function_key(file, function, source_hash)] =
+            record["arg_types"].get<std::vector<int>>();
+      } else if (type == "kernel") {
+        // records written before the triton version was recorded never match
+        std::string key = kernel_key(file,
+                                     function,
+                                     source_hash,
+                                     record["signature"].get<std::string>(),
+                                     record["options"].get<std::string>(),
+                                     record["arch"].get<unsigned int>(),
+                                     record.value("triton_version", ""),
+                                     record.value("num_scratch_args", 0));
+        this->kernel_dirs_[key] = record["dir"].get<std::string>();
+      }
+    } catch (const json::exception &e) {
+      TRITON_JIT_LOG(WARNING) << fmt::format("Skipping a malformed record in the kernel index: {}", e.what());
+    }
+  }
+}
+
+void KernelIndex::append(const std::string &line) {
+  // a single write with O_APPEND, so that records of concurrent processes do not interleave
+  int fd = ::open(this->path_.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+  if (fd < 0) {
+    TRITON_JIT_LOG(WARNING) << fmt::format("Cannot open the kernel index {}", this->path_.string());
+    return;
+  }
+  std::string data = line + "\n";
+  if (::write(fd, data.data(), data.size()) != static_cast<ssize_t>(data.size())) {
+    TRITON_JIT_LOG(WARNING) << fmt::format("Cannot write to the kernel index {}", this->path_.string());
+  }
+  ::close(fd);
+}
+
+std::optional<std::vector<int>> KernelIndex::find_static_signature(const std::string &file,
+                                                                   const std::string &function,
+                                                                   uint64_t source_hash) {
+  if (!this->enabled_) {
+    return std::nullopt;
+  }
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  auto pos = this->static_signatures_.find(function_key(file, function, source_hash));
+  if (pos == this->static_signatures_.end()) {
+    return std::nullopt;
+  }
+  return pos->second;
+}
+
+void KernelIndex::add_static_signature(const std::string &file,
+                                       const std::string &function,
+                                       uint64_t source_hash,
+                                       const std::vector<int> &arg_types) {
+  if (!this->enabled_) {
+    return;
+  }
+  json record = {{"type", "function"},
+                 {"file", file},
+                 {"function", function},
+                 {"source_hash", source_hash},
+                 {"arg_types", arg_types}};
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->static_signatures_[function_key(file, function, source_hash)] = arg_types;
+  this->append(record.dump());
+}
+
+std::optional<std::string> KernelIndex::find_kernel_dir(const std::string &file,
+                                                        const std::string &function,
+                                                        uint64_t source_hash,
+                                                        const std::string &signature,
+                                                        const std::string &options,
+                                                        unsigned int arch) {
+  if (!this->enabled_) {
+    return std::nullopt;
+  }
+  std::string dir;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    auto pos =
+        this->kernel_dirs_.find(current_kernel_key(file, function, source_hash, signature, options, arch));
+    if (pos == this->kernel_dirs_.end()) {
+      return std::nullopt;
+    }
+    dir = pos->second;
+  }
+  // the triton cache may have been cleaned since the record was written
+  std::filesystem::path kernel_dir(dir);
+  if (!std::filesystem::exists(kernel_dir / (function + ".json")) ||
+      !std::filesystem::exists(kernel_dir / (function + ".cubin"))) {
+    return std::nullopt;
+  }
+  return dir;
+}
+
+void KernelIndex::add_kernel_dir(const std::string &file,
+                                 const std::string &function,
+                                 uint64_t source_hash,
+                                 const std::string &signature,
+                                 const std::string &options,
+                                 unsigned int arch,
+                                 const std::string &dir) {
+  if (!this->enabled_) {
+    return;
+  }
+  // the version that compiled the kernel, it differs from the one the library is built for when
+  // triton is upgraded without rebuilding the library
+  std::string triton_version;
+  std::ifstream metadata_file(std::filesystem::path(dir) / (function + ".json"));
+  json metadata = json::parse(metadata_file, nullptr, /*allow_exceptions*/ false);
+  if (metadata.is_object()) {
+    triton_version = metadata.value("triton_version", "");
+  }
+  if (triton_version != get_triton_version()) {
+    static std::once_flag warned;
+    std::call_once(warned, [&]() {
+      TRITON_JIT_LOG(WARNING) << fmt::format(
+          "Kernels compiled by triton {} are not recorded in the kernel index, the library is built for "
+          "triton {}",
+          triton_version.empty() ? "of an unknown version" : triton_version,
+          get_triton_version());
+    });
+    return;
+  }
+  json record = {{"type", "kernel"},
+                 {"file", file},
+                 {"function", function},
+                 {"source_hash", source_hash},
+                 {"signature", signature},
+                 {"options", options},
+                 {"arch", arch},
+                 {"triton_version", triton_version},
+                 {"num_scratch_args", NUM_SCRATCH_ARGS},
+                 {"dir", dir}};
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->kernel_dirs_[current_kernel_key(file, function, source_hash, signature, options, arch)] = dir;
+  this->append(record.dump());
+}
+
+uint64_t KernelIndex::hash_file(const std::filesystem::path &path) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) {
+    throw std::runtime_error(fmt::format("Cannot read {}", path.string()));
+  }
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (std::istreambuf_iterator<char> it(f), end; it != end; ++it) {
+    h ^= static_cast<unsigned char>(*it);
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+}  // namespace triton_jit
@@ -0,0 +1,63 @@
+#include "triton_jit/launch_attributes.h"
+
+#include <stdexcept>
+
+#include "fmt/core.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace triton_jit {
+
+LaunchAttributes LaunchAttributes::from_metadata(std::string_view metadata) {
+  json meta_data = json::parse(metadata);
+  LaunchAttributes attributes;
+  // triton < 3.3 records the shape of a cluster, later versions only the number of blocks in it
+  auto cluster_dims = meta_data.find("cluster_dims");
+  if (cluster_dims != meta_data.end() && cluster_dims->is_array() && !cluster_dims->empty()) {
+    if (cluster_dims->size() > 3) {
+      throw std::invalid_argument(
+          fmt::format("Invalid cluster_dims in the metadata: {}", cluster_dims->dump()));
+    }
+    for (size_t i = 0; i < cluster_dims->size(); i++) {
+      attributes.cluster_dims[i] = (*cluster_dims)[i].get<unsigned int>();
+    }
+  }
+  unsigned int num_ctas = meta_data.value("num_ctas", 1u);
+  if (num_ctas == 0) {
+    throw std::invalid_argument("Invalid num_ctas in the metadata: 0");
+  }
+  if (attributes.cluster_size() == 1) {
+    attributes.cluster_dims = {num_ctas, 1, 1};
+  }
+  attributes.cooperative = meta_data.value("launch_cooperative_grid", false);
+  attributes.pdl = meta_data.value("launch_pdl", false);
+  return attributes;
+}
+
+size_t LaunchAttributes::fill(CUlaunchAttribute *attrs) const {
+  size_t n = 0;
+  if (this->cluster_size() > 1) {
+    attrs[n].id = CU_LAUNCH_ATTRIBUTE_CLUSTER_DIMENSION;
+    attrs[n].value.clusterDim.x = this->cluster_dims[0];
+    attrs[n].value.clusterDim.y = this->cluster_dims[1];
+    attrs[n].value.clusterDim.z = this->cluster_dims[2];
+    n++;
+    attrs[n].id = CU_LAUNCH_ATTRIBUTE_CLUSTER_SCHEDULING_POLICY_PREFERENCE;
+    attrs[n].value.clusterSchedulingPolicyPreference = CU_CLUSTER_SCHEDULING_POLICY_SPREAD;
+    n++;
+  }
+  if (this->cooperative) {
+    attrs[n].id = CU_LAUNCH_ATTRIBUTE_COOPERATIVE;
+    attrs[n].value.cooperative = 1;
+    n++;
+  }
+  if (this->pdl) {
+    attrs[n].id = CU_LAUNCH_ATTRIBUTE_PROGRAMMATIC_STREAM_SERIALIZATION;
+    attrs[n].value.programmaticStreamSerializationAllowed = 1;
+    n++;
+  }
+  return n;
+}
+
+}  // namespace triton_jit
@@ -0,0 +1,37 @@
+#include "triton_jit/logging.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace triton_jit {
+
+LogLevel min_log_level() {
+  static const LogLevel level = []() {
+    const char* env = std::getenv("TRITON_JIT_LOG_LEVEL");
+    std::string name = env ? env : "";
+    if (name == "INFO" || name == "0") {
+      return LogLevel::INFO;
+    } else if (name == "ERROR" || name == "2") {
+      return LogLevel::ERROR;
+    }
+    return LogLevel::WARNING;
+  }();
+  return level;
+}
+
+LogMessage::LogMessage(LogLevel level, const char* file, int line) {
+  const char* base = std::strrchr(file, '/');
+  const char tags[] = {'I', 'W', 'E'};
+  this->stream_ << '[' << tags[static_cast<int>(level)] << ' ' << (base ? base + 1 : file) << ':' << line
+                << "] ";
+}
+
+LogMessage::~LogMessage() {
+  this->stream_ << '\n';
+  std::string line = this->stream_.str();
+  std::fwrite(line.data(), 1, line.size(), stderr);
+}
+
+}  // namespace triton_jit
@@ -0,0 +1,158 @@
+#include "triton_jit/metrics.h"
+
+#include <string>
+
+#include "fmt/core.h"
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace triton_jit {
+
+void Histogram::observe(std::chrono::nanoseconds duration) {
+  double seconds = std::chrono::duration<double>(duration).count();
+  size_t bucket = 0;
+  while (bucket < BOUNDS.size() && seconds > BOUNDS[bucket]) {
+    bucket++;
+  }
+  this->counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+  this->sum_ns_.fetch_add(duration.count(), std::memory_order_relaxed);
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+  HistogramSnapshot snapshot;
+  snapshot.bounds.assign(BOUNDS.begin(), BOUNDS.end());
+  for (const std::atomic<uint64_t> &count : this->counts_) {
+    snapshot.counts.push_back(count.load(std::memory_order_relaxed));
+    snapshot.count += snapshot.counts.back();
+  }
+  snapshot.sum = this->sum_ns_.load(std::memory_order_relaxed) * 1e-9;
+  return snapshot;
+}
+
+namespace {
+json histogram_to_json(const HistogramSnapshot &h) {
+  return {{"bounds", h.bounds}, {"counts", h.counts}, {"count", h.count}, {"sum", h.sum}};
+}
+
+// label values are quoted, with backslashes, quotes & newlines escaped
+std::string escape_label(const std::string &value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      escaped += '\\';
+      escaped += c;
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+std::string function_labels(const FunctionMetrics &f) {
+  return fmt::format("file=\"{}\",function=\"{}\"", escape_label(f.file), escape_label(f.function));
+}
+
+std::string kernel_labels(const FunctionMetrics &f, const KernelMetrics &k) {
+  return fmt::format("{},signature=\"{}\",num_warps=\"{}\",num_stages=\"{}\",options=\"{}\",arch=\"{}\"",
+                     function_labels(f),
+                     escape_label(k.signature),
+                     k.num_warps,
+                     k.num_stages,
+                     escape_label(k.options),
+                     k.arch);
+}
+
+void write_header(std::string &out, const char *name, const char *type, const char *help) {
+  out += fmt::format("# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+}
+
+void write_histogram(std::string &out,
+                     const char *name,
+                     const std::string &labels,
+                     const HistogramSnapshot &h) {
+  // buckets are cumulative in the exposition format
+  uint64_t cumulative = 0;
+  for (size_t i = 0; i < h.bounds.size(); i++) {
+    cumulative += h.counts[i];
+    out += fmt::format("{}_bucket{{{},le=\"{}\"}} {}\n", name, labels, h.bounds[i], cumulative);
+  }
+  out += fmt::format("{}_bucket{{{},le=\"+Inf\"}} {}\n", name, labels, h.count);
+  out += fmt::format("{}_sum{{{}}} {}\n", name, labels, h.sum);
+  out += fmt::format("{}_count{{{}}} {}\n", name, labels, h.count);
+}
+}  // namespace
+
+std::string MetricsSnapshot::to_json() const {
+  json functions = json::array();
+  for (const FunctionMetrics &f : this->functions) {
+    json kernels = json::array();
+    for (const KernelMetrics &k : f.kernels) {
+      kernels.push_back({{"signature", k.signature},
+                         {"num_warps", k.num_warps},
+                         {"num_stages", k.num_stages},
+                         {"options", k.options},
+                         {"arch", k.arch},
+                         {"launches", k.launches},
+                         {"module_load_time", histogram_to_json(k.module_load_time)}});
+    }
+    functions.push_back({{"file", f.file},
+                         {"function", f.function},
+                         {"cache_hits", f.cache_hits},
+                         {"cache_misses", f.cache_misses},
+                         {"evictions", f.evictions},
+                         {"num_signatures", f.num_signatures},
+                         {"compile_time", histogram_to_json(f.compile_time)},
+                         {"interpreter_time", histogram_to_json(f.interpreter_time)},
+                         {"kernels", kernels}});
+  }
+  return json {{"functions", functions}}.dump();
+}
+
+std::string MetricsSnapshot::to_prometheus() const {
+  std::string out;
+  write_header(out, "triton_jit_kernel_cache_hits_total", "counter", "Kernel lookups served by the cache.");
+  for (const FunctionMetrics &f : this->functions) {
+    out += fmt::format("triton_jit_kernel_cache_hits_total{{{}}} {}\n", function_labels(f), f.cache_hits);
+  }
+  write_header(out, "triton_jit_kernel_cache_misses_total", "counter", "Kernel lookups that compiled.");
+  for (const FunctionMetrics &f : this->functions) {
+    out += fmt::format("triton_jit_kernel_cache_misses_total{{{}}} {}\n", function_labels(f), f.cache_misses);
+  }
+  write_header(out, "triton_jit_kernel_evictions_total", "counter", "Kernels evicted from the cache.");
+  for (const FunctionMetrics &f : this->functions) {
+    out += fmt::format("triton_jit_kernel_evictions_total{{{}}} {}\n", function_labels(f), f.evictions);
+  }
+  write_header(out, "triton_jit_signatures", "gauge", "Distinct signatures of the cached kernels.");
+  for (const FunctionMetrics &f : this->functions) {
+    out += fmt::format("triton_jit_signatures{{{}}} {}\n", function_labels(f), f.num_signatures);
+  }
+  write_header(out, "triton_jit_compile_seconds", "histogram", "Wall time to get a kernel on a miss.");
+  for (const FunctionMetrics &f : this->functions) {
+    write_histogram(out, "triton_jit_compile_seconds", function_labels(f), f.compile_time);
+  }
+  write_header(
+      out, "triton_jit_interpreter_seconds", "histogram", "Time spent in the embedded python interpreter.");
+  for (const FunctionMetrics &f : this->functions) {
+    write_histogram(out, "triton_jit_interpreter_seconds", function_labels(f), f.interpreter_time);
+  }
+  write_header(out, "triton_jit_kernel_launches_total", "counter", "Launches of a kernel.");
+  for (const FunctionMetrics &f : this->functions) {
+    for (const KernelMetrics &k : f.kernels) {
+      out += fmt::format("triton_jit_kernel_launches_total{{{}}} {}\n", kernel_labels(f, k), k.launches);
+    }
+  }
+  write_header(
+      out, "triton_jit_module_load_seconds", "histogram", "Time to load a kernel into a device.");
+  for (const FunctionMetrics &f : this->functions) {
+    for (const KernelMetrics &k : f.kernels) {
+      write_histogram(out, "triton_jit_module_load_seconds", kernel_labels(f, k), k.module_load_time);
+    }
+  }
+  return out;
+}
+
+}  // namespace triton_jit
@@ -0,0 +1,130 @@
+#include "triton_jit/module_cache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "fmt/core.h"
+#include "triton_jit/driver.h"
+#include "triton_jit/logging.h"
+
+namespace triton_jit {
+
+namespace {
+uint64_t fnv1a(const void *data, size_t size) {
+  const unsigned char *p = static_cast<const unsigned char *>(data);
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < size; i++) {
+    h ^= p[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+}  // namespace
+
+MappedFile::MappedFile(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error(fmt::format("Cannot open {}: {}", path, std::strerror(errno)));
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error(fmt::format("Cannot stat {}: {}", path, std::strerror(errno)));
+  }
+  this->size_ = static_cast<size_t>(st.st_size);
+  if (this->size_ == 0) {
+    ::close(fd);
+    throw std::runtime_error(fmt::format("{} is empty", path));
+  }
+  void *data = ::mmap(nullptr, this->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping stays valid after the file is closed
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    throw std::runtime_error(fmt::format("Cannot map {}: {}", path, std::strerror(errno)));
+  }
+  this->data_ = data;
+}
+
+MappedFile::~MappedFile() {
+  if (this->data_) {
+    ::munmap(this->data_, this->size_);
+  }
+}
+
+std::shared_ptr<const CubinImage> CubinImage::from_file(const std::string &path) {
+  auto file = std::make_shared<const MappedFile>(path);
+  return std::make_shared<const CubinImage>(
+      CubinImage {file->data(), file->size(), fnv1a(file->data(), file->size()), file});
+}
+
+std::shared_ptr<const CubinImage> CubinImage::from_memory(const void *data, size_t size) {
+  return std::make_shared<const CubinImage>(CubinImage {data, size, fnv1a(data, size), nullptr});
+}
+
+bool CubinImage::same_content(const CubinImage &other) const {
+  return this->hash == other.hash && this->size == other.size &&
+         (this->data == other.data || std::memcmp(this->data, other.data, this->size) == 0);
+}
+
+ModuleTable &ModuleTable::get() {
+  // leaked on purpose, modules are released when the contexts are destroyed
+  static ModuleTable *table = new ModuleTable();
+  return *table;
+}
+
+CUmodule ModuleTable::load(CUdevice device, const std::shared_ptr<const CubinImage> &image) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  std::vector<Entry> &entries = this->modules_[image->hash];
+  for (Entry &entry : entries) {
+    if (entry.device == device && entry.image->same_content(*image)) {
+      entry.refs++;
+      return entry.module;
+    }
+  }
+  TRITON_JIT_LOG(INFO) << fmt::format("Loading a cubin of {} bytes (hash {:016x}) into device {}",
+                                      image->size,
+                                      image->hash,
+                                      device);
+  CUmodule module = Driver::get().load_module(device, image->data);
+  entries.push_back({device, image, module, 1});
+  return module;
+}
+
+void ModuleTable::release(CUdevice device, const CubinImage &image) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  auto pos = this->modules_.find(image.hash);
+  if (pos == this->modules_.end()) {
+    return;
+  }
+  std::vector<Entry> &entries = pos->second;
+  for (auto it = entries.begin(); it != entries.end(); ++it) {
+    if (it->device == device && it->image->same_content(image)) {
+      if (--it->refs == 0) {
+        TRITON_JIT_LOG(INFO) << fmt::format(
+            "Unloading a cubin (hash {:016x}) from device {}", image.hash, device);
+        Driver::get().unload_module(device, it->module);
+        entries.erase(it);
+        if (entries.empty()) {
+          this->modules_.erase(pos);
+        }
+      }
+      return;
+    }
+  }
+}
+
+size_t ModuleTable::num_modules() const {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  size_t n = 0;
+  for (const auto &item : this->modules_) {
+    n += item.second.size();
+  }
+  return n;
+}
+
+}  // namespace triton_jit
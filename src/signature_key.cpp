@@ -0,0 +1,163 @@
+#include "triton_jit/signature_key.h"
+
+#include <charconv>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "fmt/core.h"
+
+namespace triton_jit {
+
+namespace {
+std::string_view trim(std::string_view s) {
+  size_t begin = s.find_first_not_of(" \t");
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  size_t end = s.find_last_not_of(" \t");
+  return s.substr(begin, end - begin + 1);
+}
+
+bool parse_triton_type(std::string_view name, TritonType &out) {
+  for (uint8_t i = 0; i <= static_cast<uint8_t>(TritonType::FP64); i++) {
+    if (name == triton_typename(TritonType(i))) {
+      out = TritonType(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+Spec parse_spec(std::string_view s) {
+  if (s.empty()) {
+    return Spec::NONE;
+  } else if (s == "16") {
+    return Spec::DIV16;
+  } else if (s == "1") {
+    return Spec::ONE;
+  }
+  throw std::invalid_argument(fmt::format("Only 1 and 16 are valid hints, got {}", s));
+}
+}  // namespace
+
+std::string SignatureKey::to_signature() const {
+  std::string out;
+  out.reserve(this->words_.size() * 6);
+  for (size_t i = 0; i < this->words_.size(); i++) {
+    if (!out.empty()) {
+      out.push_back(',');
+    }
+    uint64_t w = this->words_[i];
+    Kind kind = Kind(w & 0xff);
+    TritonType dtype = TritonType((w >> 8) & 0xff);
+    Spec spec = Spec((w >> 16) & 0xff);
+    switch (kind) {
+      case Kind::POINTER:
+        out += fmt::format("*{}{}", triton_typename(dtype), spec_suffix(spec));
+        break;
+      case Kind::SCALAR:
+        out += fmt::format("{}{}", triton_typename(dtype), spec_suffix(spec));
+        break;
+      case Kind::NULLOPT:
+        out += "nullopt";
+        break;
+      default: {
+        uint64_t bits = this->words_[++i];
+        if (kind == Kind::CONSTEXPR_INT) {
+          out += fmt::format("{}", static_cast<int64_t>(bits));
+        } else if (kind == Kind::CONSTEXPR_UINT) {
+          out += fmt::format("{}", bits);
+        } else if (kind == Kind::CONSTEXPR_BOOL) {
+          out += fmt::format("{}", bits != 0);
+        } else if (kind == Kind::CONSTEXPR_FP32) {
+          float v;
+          std::memcpy(&v, &bits, sizeof(float));
+          out += fmt::format("{}", v);
+        } else {
+          double v;
+          std::memcpy(&v, &bits, sizeof(double));
+          out += fmt::format("{}", v);
+        }
+        break;
+      }
+    }
+  }
+  return out;
+}
+
+bool SignatureKey::relaxes(const SignatureKey &specialized) const {
+  if (this->words_.size() != specialized.words_.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < this->words_.size(); i++) {
+    uint64_t w = this->words_[i];
+    uint64_t s = specialized.words_[i];
+    Kind kind = Kind(w & 0xff);
+    if (kind != Kind::POINTER && kind != Kind::SCALAR && kind != Kind::NULLOPT) {
+      // constexpr, the value word follows
+      if (w != s || this->words_[i + 1] != specialized.words_[i + 1]) {
+        return false;
+      }
+      i++;
+      continue;
+    }
+    if (w == s) {
+      continue;
+    }
+    uint64_t spec_mask = tag(Kind(0), TritonType(0), Spec(0xff));
+    bool dropped_div16 = (w & ~spec_mask) == (s & ~spec_mask) && Spec((s >> 16) & 0xff) == Spec::DIV16 &&
+                         Spec((w >> 16) & 0xff) == Spec::NONE;
+    if (!dropped_div16) {
+      return false;
+    }
+  }
+  return true;
+}
+
+SignatureKey SignatureKey::from_signature(std::string_view signature) {
+  SignatureKey key;
+  while (!signature.empty()) {
+    size_t comma = signature.find(',');
+    std::string_view item = trim(signature.substr(0, comma));
+    signature = comma == std::string_view::npos ? std::string_view() : signature.substr(comma + 1);
+
+    size_t colon = item.find(':');
+    std::string_view type_part = item.substr(0, colon);
+    Spec spec = colon == std::string_view::npos ? Spec::NONE : parse_spec(item.substr(colon + 1));
+    TritonType dtype;
+    if (item == "nullopt") {
+      key.push_nullopt();
+    } else if (!type_part.empty() && type_part[0] == '*' && parse_triton_type(type_part.substr(1), dtype)) {
+      key.push_pointer(dtype, spec);
+    } else if (parse_triton_type(type_part, dtype)) {
+      key.push_scalar(dtype, spec);
+    } else if (item == "true" || item == "false") {
+      key.push_constexpr(item == "true");
+    } else {
+      const char *last = item.data() + item.size();
+      int64_t iv;
+      auto [ptr, ec] = std::from_chars(item.data(), last, iv);
+      if (ec == std::errc() && ptr == last) {
+        key.push_constexpr(iv);
+        continue;
+      }
+      uint64_t uv;
+      auto [uptr, uec] = std::from_chars(item.data(), last, uv);
+      if (uec == std::errc() && uptr == last) {
+        key.push_constexpr(uv);
+        continue;
+      }
+      std::string s(item);
+      char *end = nullptr;
+      double dv = std::strtod(s.c_str(), &end);
+      if (s.empty() || end != s.c_str() + s.size()) {
+        throw std::invalid_argument(fmt::format("Invalid item in signature: {}", item));
+      }
+      key.push_constexpr(dv);
+    }
+  }
+  return key;
+}
+
+}  // namespace triton_jit
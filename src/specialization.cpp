@@ -0,0 +1,84 @@
+#include "triton_jit/specialization.h"
+
+#include <algorithm>
+
+#include "fmt/core.h"
+
+namespace triton_jit {
+
+std::string SpecializationPolicy::to_string() const {
+  std::string out;
+  for (const auto &[index, arg] : this->args_) {
+    out += fmt::format("{}{}:", out.empty() ? "" : ";", index);
+    out += arg.mode == Mode::SPECIALIZE ? "spec" : arg.mode == Mode::DO_NOT_SPECIALIZE ? "nospec" : "default";
+    if (arg.assume_aligned) {
+      out += ",aligned";
+    }
+    if (arg.never_one) {
+      out += ",never_one";
+    }
+  }
+  return out;
+}
+
+std::string SpecializationReport::to_string() const {
+  std::string out = fmt::format("{} variants", this->num_variants);
+  for (const Argument &arg : this->arguments) {
+    out += fmt::format("; argument {}:", arg.index);
+    for (size_t i = 0; i < arg.values.size(); i++) {
+      out += fmt::format("{} {} ({})", i == 0 ? "" : ",", arg.values[i].first, arg.values[i].second);
+    }
+  }
+  return out;
+}
+
+std::optional<SpecializationReport> SpecializationTracker::record(const std::string &signature,
+                                                                  size_t max_variants) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  if (!this->signatures_.insert(signature).second) {
+    return std::nullopt;
+  }
+  // arguments are separated by commas, which are not in any of them
+  size_t begin = 0;
+  for (size_t index = 0;; index++) {
+    size_t end = std::min(signature.find(',', begin), signature.size());
+    if (this->values_.size() <= index) {
+      this->values_.resize(index + 1);
+    }
+    this->values_[index][signature.substr(begin, end - begin)]++;
+    if (end == signature.size()) {
+      break;
+    }
+    begin = end + 1;
+  }
+  if (max_variants == 0 || this->exceeded_ || this->signatures_.size() <= max_variants) {
+    return std::nullopt;
+  }
+  this->exceeded_ = true;
+  return this->report_locked();
+}
+
+SpecializationReport SpecializationTracker::report() const {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->report_locked();
+}
+
+SpecializationReport SpecializationTracker::report_locked() const {
+  SpecializationReport report;
+  report.num_variants = this->signatures_.size();
+  for (size_t i = 0; i < this->values_.size(); i++) {
+    if (this->values_[i].size() < 2) {
+      continue;
+    }
+    SpecializationReport::Argument arg {static_cast<int>(i), {}};
+    arg.values.assign(this->values_[i].begin(), this->values_[i].end());
+    // the most frequent values first
+    std::stable_sort(arg.values.begin(), arg.values.end(), [](const auto &a, const auto &b) {
+      return a.second > b.second;
+    });
+    report.arguments.push_back(std::move(arg));
+  }
+  return report;
+}
+
+}  // namespace triton_jit
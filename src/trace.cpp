@@ -0,0 +1,155 @@
+#include "triton_jit/trace.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "fmt/core.h"
+#include "nlohmann/json.hpp"
+#include "triton_jit/logging.h"
+
+using json = nlohmann::json;
+
+namespace triton_jit {
+
+std::atomic<bool> Tracer::enabled_ {false};
+
+namespace {
+// TRITON_JIT_TRACE=<path>: trace from startup, and write the trace to the path at exit
+[[maybe_unused]] const bool trace_from_env = []() {
+  const char* path = std::getenv("TRITON_JIT_TRACE");
+  if (!path || !*path) {
+    return false;
+  }
+  static std::string trace_path = path;
+  Tracer::get();
+  Tracer::set_enabled(true);
+  std::atexit([]() {
+    try {
+      Tracer::get().write(trace_path);
+    } catch (const std::exception& e) {
+      TRITON_JIT_LOG(WARNING) << fmt::format("Cannot write the trace to {}: {}", trace_path, e.what());
+    }
+  });
+  return true;
+}();
+
+template <size_t N>
+void copy_truncated(char (&dst)[N], std::string_view src) {
+  size_t n = std::min(src.size(), N - 1);
+  std::memcpy(dst, src.data(), n);
+  dst[n] = '\0';
+}
+}  // namespace
+
+Tracer& Tracer::get() {
+  // leaked on purpose, so that it is alive in atexit handlers & in threads that outlive main
+  static Tracer* tracer = new Tracer();
+  return *tracer;
+}
+
+Tracer::ThreadBuffer& Tracer::thread_buffer() {
+  thread_local ThreadBuffer* buffer = nullptr;
+  if (!buffer) {
+    auto b = std::make_shared<ThreadBuffer>();
+    b->tid = static_cast<int64_t>(::syscall(SYS_gettid));
+    std::lock_guard<std::mutex> lock(this->buffers_mutex_);
+    this->buffers_.push_back(b);
+    buffer = b.get();
+  }
+  return *buffer;
+}
+
+void Tracer::record(const TraceEvent& event) {
+  ThreadBuffer& buffer = this->thread_buffer();
+  uint64_t head = buffer.head.load(std::memory_order_relaxed);
+  buffer.events[head % BUFFER_EVENTS] = event;
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+
+std::string Tracer::to_json() const {
+  json events = json::array();
+  int64_t pid = ::getpid();
+  std::lock_guard<std::mutex> lock(this->buffers_mutex_);
+  for (const std::shared_ptr<ThreadBuffer>& buffer : this->buffers_) {
+    uint64_t head = buffer->head.load(std::memory_order_acquire);
+    uint64_t begin = std::max(buffer->tail.load(std::memory_order_relaxed),
+                              head > BUFFER_EVENTS ? head - BUFFER_EVENTS : uint64_t(0));
+    std::vector<TraceEvent> copied;
+    copied.reserve(head - begin);
+    for (uint64_t i = begin; i < head; i++) {
+      copied.push_back(buffer->events[i % BUFFER_EVENTS]);
+    }
+    // events overwritten by the thread while they were copied are dropped
+    uint64_t new_head = buffer->head.load(std::memory_order_acquire);
+    uint64_t valid = new_head > BUFFER_EVENTS ? new_head - BUFFER_EVENTS : 0;
+    for (uint64_t i = std::max(begin, valid); i < head; i++) {
+      const TraceEvent& e = copied[i - begin];
+      json args = json::object();
+      if (e.function[0]) {
+        args["function"] = e.function;
+      }
+      if (e.signature[0]) {
+        args["signature"] = e.signature;
+      }
+      if (e.device >= 0) {
+        args["device"] = e.device;
+      }
+      if (e.arch) {
+        args["arch"] = e.arch;
+      }
+      events.push_back({{"name", e.name},
+                        {"cat", "triton_jit"},
+                        {"ph", "X"},
+                        {"ts", e.start_ns / 1000.0},
+                        {"dur", e.duration_ns / 1000.0},
+                        {"pid", pid},
+                        {"tid", buffer->tid},
+                        {"args", args}});
+    }
+  }
+  return json {{"traceEvents", events}, {"displayTimeUnit", "ns"}}.dump();
+}
+
+void Tracer::write(const std::string& path) const {
+  std::ofstream f(path);
+  if (!f) {
+    throw std::runtime_error(fmt::format("Cannot open {}", path));
+  }
+  f << this->to_json();
+}
+
+void Tracer::clear() {
+  std::lock_guard<std::mutex> lock(this->buffers_mutex_);
+  for (const std::shared_ptr<ThreadBuffer>& buffer : this->buffers_) {
+    buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+  }
+}
+
+TraceSpan::TraceSpan(
+    const char* name, std::string_view function, std::string_view signature, int device, unsigned int arch)
+    : active_(Tracer::enabled()) {
+  if (!this->active_) {
+    return;
+  }
+  this->event_.name = name;
+  this->event_.device = device;
+  this->event_.arch = arch;
+  copy_truncated(this->event_.function, function);
+  copy_truncated(this->event_.signature, signature);
+  this->event_.start_ns = Tracer::get().now_ns();
+}
+
+TraceSpan::~TraceSpan() {
+  if (!this->active_) {
+    return;
+  }
+  Tracer& tracer = Tracer::get();
+  this->event_.duration_ns = tracer.now_ns() - this->event_.start_ns;
+  tracer.record(this->event_);
+}
+
+}  // namespace triton_jit
@@ -2,123 +2,716 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 #include <type_traits>
 #include <utility>
-#include "c10/util/Logging.h"  // use torch's logging
+#include <variant>
 #include "fmt/core.h"
 #include "nlohmann/json.hpp"
+#include "triton_jit/compile_workers.h"
+#include "triton_jit/embedded_kernels.h"
+#include "triton_jit/kernel_index.h"
+#include "triton_jit/logging.h"
+#include "triton_jit/trace.h"
 
 #include "pybind11/embed.h"
 
 namespace triton_jit {
-std::unordered_map<std::string, TritonJITFunction> TritonJITFunction::functions_;
+std::unordered_map<std::string, std::unique_ptr<TritonJITFunction>> TritonJITFunction::functions_;
+ShardedSharedMutex TritonJITFunction::functions_mutex_;
+std::atomic<size_t> TritonJITFunction::max_cached_kernels_ {[]() -> size_t {
+  const char* env = std::getenv("TRITON_JIT_MAX_KERNELS");
+  return env ? std::strtoull(env, nullptr, 10) : 0;
+}()};
+std::atomic<size_t> TritonJITFunction::num_cached_kernels_ {0};
+std::atomic<uint64_t> TritonJITFunction::lru_clock_ {0};
 
 void ensure_initialized() {
-  // When using libtriton_jit with a python C-extension, it is already initialized
-  c10::initLogging();
-  if (!Py_IsInitialized()) {
-    Py_InitializeEx(false);
+  static std::once_flag init_flag;
+  std::call_once(init_flag, []() {
+    // When using libtriton_jit with a python C-extension, it is already initialized
+    if (!Py_IsInitialized()) {
+      Py_InitializeEx(false);
+      // Py_InitializeEx leaves the GIL held by this thread, release it so that other threads
+      // can acquire it with gil_scoped_acquire
+      PyEval_SaveThread();
+    }
+  });
+}
+
+namespace {
+/**
+ * Methods of the compiler session of the embedded interpreter (scripts/compiler_session.py),
+ * which keeps the loaded jit functions across compiles. They are resolved once and never released,
+ * since they may outlive the interpreter.
+ */
+struct CompilerSession {
+  pybind11::object extract_static_signature;
+  pybind11::object extract_autotune_configs;
+  pybind11::object compile_a_kernel;
+  pybind11::object json_dumps;
+};
+
+// the GIL must be held. It also guards the session, a function-local static could deadlock with it,
+// since the import may release the GIL
+const CompilerSession& compiler_session() {
+  namespace py = pybind11;
+  static CompilerSession* session = nullptr;
+  if (session) {
+    return *session;
+  }
+  std::string script_dir = get_script_dir().string();
+  py::object sys_path = py::module_::import("sys").attr("path");
+  if (!sys_path.contains(script_dir)) {
+    sys_path.attr("insert")(0, script_dir);
+  }
+  py::object instance = py::module_::import("compiler_session").attr("session");
+  if (!session) {
+    session = new CompilerSession {instance.attr("extract_static_signature"),
+                                   instance.attr("extract_autotune_configs"),
+                                   instance.attr("compile_a_kernel"),
+                                   py::module_::import("json").attr("dumps")};
+  }
+  return *session;
+}
+}  // namespace
+
+namespace {
+size_t default_max_variants() {
+  static const size_t max_variants = []() -> size_t {
+    const char* env = std::getenv("TRITON_JIT_MAX_VARIANTS");
+    return env ? std::strtoull(env, nullptr, 10) : 8;
+  }();
+  return max_variants;
+}
+}  // namespace
+
+TritonJITFunction::TritonJITFunction(std::string_view path,
+                                     std::string_view name,
+                                     const SpecializationPolicy& policy)
+    : file_path_(std::string(path)),
+      function_name_(std::string(name)),
+      max_variants_(default_max_variants()) {
+  // functions embedded at build time do not need python
+  this->embedded_ = EmbeddedKernelRegistry::get().find_function(path, name);
+  if (const EmbeddedFunction* embedded = this->embedded_) {
+    std::vector<ArgType> arg_types;
+    for (int i = 0; i < embedded->num_args; i++) {
+      arg_types.push_back(ArgType(embedded->arg_types[i]));
+    }
+    this->static_sig_ = StaticSignature {embedded->num_args, arg_types, {}};
+    this->apply_policy(policy);
+    return;
+  }
+
+  // a warm restart takes the static signature from the kernel index, without python
+  KernelIndex& index = KernelIndex::get();
+  std::optional<uint64_t> source_hash = this->source_hash();
+  std::optional<std::vector<int>> arg_types_raw;
+  if (source_hash) {
+    arg_types_raw = index.find_static_signature(this->source_path(), this->function_name_, *source_hash);
+  }
+  if (!arg_types_raw) {
+    arg_types_raw = this->extract_static_signature();
+    if (source_hash) {
+      index.add_static_signature(this->source_path(), this->function_name_, *source_hash, *arg_types_raw);
+    }
+  }
+
+  int num_args = arg_types_raw->size();
+  std::vector<ArgType> arg_types;
+  arg_types.reserve(num_args);
+  for (int item : *arg_types_raw) {
+    arg_types.push_back(ArgType(item));
+  }
+  this->static_sig_ = StaticSignature {num_args, arg_types, {}};
+  this->apply_policy(policy);
+}
+
+void TritonJITFunction::apply_policy(const SpecializationPolicy& policy) {
+  if (policy.empty()) {
+    return;
+  }
+  StaticSignature& ssig = this->static_sig_;
+  ssig.overrides.assign(ssig.num_args, SpecializationPolicy::Arg {});
+  for (const auto& [index, arg] : policy.args()) {
+    if (index < 0 || index >= ssig.num_args) {
+      throw std::invalid_argument(fmt::format("The specialization policy of {} refers to argument {} of {}",
+                                              this->function_name_,
+                                              index,
+                                              ssig.num_args));
+    }
+    if (ssig.arg_type[index] == ArgType::CONSTEXPR) {
+      throw std::invalid_argument(fmt::format(
+          "Argument {} of {} is a constexpr, it cannot be overridden", index, this->function_name_));
+    }
+    if (arg.mode == SpecializationPolicy::Mode::DO_NOT_SPECIALIZE && arg.assume_aligned) {
+      throw std::invalid_argument(fmt::format(
+          "Argument {} of {} is assumed aligned but not specialized", index, this->function_name_));
+    }
+    if (arg.mode == SpecializationPolicy::Mode::SPECIALIZE) {
+      ssig.arg_type[index] = ArgType::SPECIALIZED;
+    } else if (arg.mode == SpecializationPolicy::Mode::DO_NOT_SPECIALIZE) {
+      ssig.arg_type[index] = ArgType::NON_CONSTEXPR;
+    }
+    ssig.overrides[index] = arg;
   }
 }
 
-TritonJITFunction::TritonJITFunction(std::string_view path, std::string_view name)
-    : file_path_(std::string(path)), function_name_(std::string(name)) {
+std::vector<int> TritonJITFunction::extract_static_signature() const {
+  TraceSpan span("static_signature", this->function_name_);
+  if (CompileWorkerPool* workers = CompileWorkerPool::get()) {
+    try {
+      return workers->extract_static_signature(this->source_path(), this->function_name_);
+    } catch (const CompileWorkerError& e) {
+      TRITON_JIT_LOG(WARNING) << fmt::format("{}, falling back to the embedded interpreter", e.what());
+    }
+  }
+
   // embed python
   namespace py = pybind11;
   ensure_initialized();
   py::gil_scoped_acquire gil;
+  ScopedTimer timer(this->interpreter_time_);
 
-  std::filesystem::path script_dir = get_script_dir();
-  py::module_ sys = py::module_::import("sys");
-  sys.attr("path").attr("insert")(0, script_dir.c_str());
-  py::module_ mod = py::module_::import("gen_ssig");
-  py::object fn = mod.attr("extract_static_signature");
-  py::object ans = fn(this->file_path_, this->function_name_);
+  py::object ans = compiler_session().extract_static_signature(this->file_path_, this->function_name_);
   py::list arg_types_raw = ans.cast<py::list>();
 
-  int num_args = arg_types_raw.size();
-  std::vector<ArgType> arg_types;
-  arg_types.reserve(num_args);
+  std::vector<int> arg_types;
+  arg_types.reserve(arg_types_raw.size());
   for (auto item : arg_types_raw) {
     try {
-      arg_types.push_back(ArgType(item.cast<int>()));
+      arg_types.push_back(item.cast<int>());
     } catch (const py::cast_error& e) {
       std::cerr << "Type error: " << e.what() << std::endl;
     }
   }
-  this->static_sig_ = StaticSignature {num_args, arg_types};
+  return arg_types;
 }
 
-const TritonKernel& TritonJITFunction::get_kernel(std::string_view _signature,
-                                                  int num_warps,
-                                                  int num_stages,
+std::string TritonJITFunction::extract_autotune_configs() const {
+  if (CompileWorkerPool* workers = CompileWorkerPool::get()) {
+    try {
+      return workers->extract_autotune_configs(this->source_path(), this->function_name_);
+    } catch (const CompileWorkerError& e) {
+      TRITON_JIT_LOG(WARNING) << fmt::format("{}, falling back to the embedded interpreter", e.what());
+    }
+  }
+
+  // embed python
+  namespace py = pybind11;
+  ensure_initialized();
+  py::gil_scoped_acquire gil;
+  ScopedTimer timer(this->interpreter_time_);
+  const CompilerSession& session = compiler_session();
+  py::object ans = session.extract_autotune_configs(this->file_path_, this->function_name_);
+  return session.json_dumps(ans).cast<std::string>();
+}
+
+std::string TritonJITFunction::source_path() const {
+  return std::filesystem::absolute(this->file_path_).lexically_normal().string();
+}
+
+std::optional<uint64_t> TritonJITFunction::source_hash() const {
+  if (!KernelIndex::get().enabled()) {
+    return std::nullopt;
+  }
+  try {
+    return KernelIndex::hash_file(this->file_path_);
+  } catch (const std::runtime_error& e) {
+    // let the python side report that the source cannot be loaded
+    return std::nullopt;
+  }
+}
+
+namespace {
+// Wait for a compile in another thread. If the caller holds the GIL (e.g. an op called from
+// python), release it while waiting, since the compiling thread needs it.
+const TritonKernel* wait_for_compile(const std::shared_future<const TritonKernel*>& future) {
+  if (Py_IsInitialized() && PyGILState_Check()) {
+    pybind11::gil_scoped_release no_gil;
+    future.wait();
+  }
+  return future.get();
+}
+
+// A fixed-size pool of threads for background compiles. Its threads are detached and live until
+// the process exits, so that they never join while the interpreter is being finalized.
+class CompilePool {
+ public:
+  explicit CompilePool(int num_threads) {
+    for (int i = 0; i < num_threads; i++) {
+      std::thread([this]() { this->worker_loop(); }).detach();
+    }
+  }
+
+  void submit(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      this->tasks_.push_back(std::move(task));
+    }
+    this->cv_.notify_one();
+  }
+
+ private:
+  void worker_loop() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(this->mutex_);
+        this->cv_.wait(lock, [this]() { return !this->tasks_.empty(); });
+        task = std::move(this->tasks_.front());
+        this->tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+};
+
+CompilePool& compile_pool() {
+  static CompilePool* pool = []() {
+    int num_threads = std::min(4u, std::max(1u, std::thread::hardware_concurrency()));
+    if (const char* env = std::getenv("TRITON_JIT_COMPILE_THREADS")) {
+      num_threads = std::max(1, std::atoi(env));
+    }
+    return new CompilePool(num_threads);  // leaked on purpose, see CompilePool
+  }();
+  return *pool;
+}
+}  // namespace
+
+const TritonKernel& TritonJITFunction::get_kernel(std::string_view signature,
+                                                  const CompileOptions& options,
+                                                  CUdevice device_index) const {
+  return this->get_kernel(SignatureKey::from_signature(signature), options, device_index);
+}
+
+const TritonKernel& TritonJITFunction::get_kernel(const SignatureKey& sig_key,
+                                                  const CompileOptions& options,
                                                   CUdevice device_index) const {
-  std::string signature(_signature);
-  std::string key = fmt::format("{};{}", signature, device_index);
+  KernelKey key {sig_key, options, Driver::get().device_arch(device_index)};
+  if (const TritonKernel* kernel = this->find_kernel(key)) {
+    this->cache_hits_.add();
+    TritonJITFunction::touch(kernel);
+    return *kernel;
+  }
+  this->cache_misses_.add();
+  if (this->tiered_.load(std::memory_order_relaxed)) {
+    std::shared_future<const TritonKernel*> future = this->schedule_compile(key, /*async*/ true);
+    if (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      if (const TritonKernel* relaxed = this->find_relaxed_kernel(key)) {
+        return *relaxed;
+      }
+    }
+    return *wait_for_compile(future);
+  }
+  return *wait_for_compile(this->schedule_compile(key, /*async*/ false));
+}
+
+const TritonKernel* TritonJITFunction::find_kernel(const KernelKey& key) const {
+  std::shared_lock<ShardedSharedMutex> lock(this->overloads_mutex_);
   auto pos = this->overloads_.find(key);
-  if (pos == this->overloads_.end()) {
-    // embed python
-    namespace py = pybind11;
-    ensure_initialized();
-    py::gil_scoped_acquire gil;
-
-    std::filesystem::path script_dir = get_script_dir();
-    py::module_ sys = py::module_::import("sys");
-    sys.attr("path").attr("insert")(0, script_dir.c_str());
-    py::module_ mod = py::module_::import("standalone_compile");
-    py::object fn = mod.attr("compile_a_kernel");
-    py::object ans;
+  return pos == this->overloads_.end() ? nullptr : pos->second.get();
+}
+
+const TritonKernel* TritonJITFunction::find_relaxed_kernel(const KernelKey& key) const {
+  std::shared_lock<ShardedSharedMutex> lock(this->overloads_mutex_);
+  for (const auto& [k, kernel] : this->overloads_) {
+    if (k.arch == key.arch && k.options == key.options && k.signature.relaxes(key.signature)) {
+      return kernel.get();
+    }
+  }
+  return nullptr;
+}
+
+std::shared_future<const TritonKernel*> TritonJITFunction::precompile(std::string_view signature,
+                                                                      const CompileOptions& options,
+                                                                      CUdevice device_index) const {
+  unsigned int arch = Driver::get().device_arch(device_index);
+  KernelKey key {SignatureKey::from_signature(signature), options, arch};
+  return this->schedule_compile(key, /*async*/ true);
+}
+
+std::vector<std::shared_future<const TritonKernel*>> TritonJITFunction::precompile(
+    const std::vector<PrecompileRequest>& requests) const {
+  std::vector<std::shared_future<const TritonKernel*>> futures;
+  futures.reserve(requests.size());
+  for (const PrecompileRequest& r : requests) {
+    futures.push_back(this->precompile(r.signature, r.options, r.device_index));
+  }
+  return futures;
+}
+
+std::shared_future<const TritonKernel*> TritonJITFunction::schedule_compile(const KernelKey& key,
+                                                                            bool async) const {
+  auto promise = std::make_shared<std::promise<const TritonKernel*>>();
+  std::shared_future<const TritonKernel*> future = promise->get_future().share();
+  {
+    std::lock_guard<std::mutex> lock(this->pending_mutex_);
+    auto pos = this->pending_.find(key);
+    if (pos != this->pending_.end()) {
+      return pos->second;
+    }
+    // a kernel is published before its pending entry is removed, so check again here
+    if (const TritonKernel* kernel = this->find_kernel(key)) {
+      promise->set_value(kernel);
+      return future;
+    }
+    this->pending_.emplace(key, future);
+  }
+
+  // this thread or the pool owns the compile of the key, waiters get the result or the exception
+  if (async) {
+    compile_pool().submit([this, key, promise]() { this->run_compile(key, *promise); });
+  } else {
+    this->run_compile(key, *promise);
+  }
+  return future;
+}
+
+void TritonJITFunction::run_compile(const KernelKey& key, std::promise<const TritonKernel*>& promise) const {
+  try {
+    std::unique_ptr<TritonKernel> kernel;
+    {
+      ScopedTimer timer(this->compile_time_);
+      TraceSpan span("compile",
+                     this->function_name_,
+                     Tracer::enabled() ? key.signature.to_signature() : std::string(),
+                     /*device*/ -1,
+                     key.arch);
+      kernel = this->compile_kernel(key);
+    }
+    promise.set_value(this->publish_kernel(key, std::move(kernel)));
+  } catch (...) {
+    promise.set_exception(std::current_exception());
+  }
+  std::lock_guard<std::mutex> lock(this->pending_mutex_);
+  this->pending_.erase(key);
+}
+
+std::unique_ptr<TritonKernel> TritonJITFunction::compile_kernel(const KernelKey& key) const {
+  // the string signature is only needed by the compiler
+  std::string signature = key.signature.to_signature();
+  std::string options = key.options.to_string();
+  unsigned int arch = key.arch;
+
+  // kernels embedded at build time come first
+  const EmbeddedKernel* embedded =
+      this->embedded_ ? EmbeddedKernelRegistry::get().find_kernel(*this->embedded_, signature, options, arch)
+                      : nullptr;
+  if (embedded) {
+    return std::unique_ptr<TritonKernel>(
+        new TritonKernel(this->function_name_, embedded->metadata, embedded->cubin, embedded->cubin_size));
+  }
+
+  // the kernel may have been compiled by a previous process, or evicted from the cache
+  KernelIndex& index = KernelIndex::get();
+  std::optional<uint64_t> source_hash = this->source_hash();
+  if (source_hash) {
+    std::optional<std::string> dir = index.find_kernel_dir(
+        this->source_path(), this->function_name_, *source_hash, signature, options, arch);
+    if (dir) {
+      return std::unique_ptr<TritonKernel>(new TritonKernel(*dir, this->function_name_));
+    }
+  }
+
+  std::string cache_dir = this->run_compiler(signature, key.options, arch);
+  if (source_hash) {
+    index.add_kernel_dir(
+        this->source_path(), this->function_name_, *source_hash, signature, options, arch, cache_dir);
+  }
+  return std::unique_ptr<TritonKernel>(new TritonKernel(cache_dir, this->function_name_));
+}
+
+std::string TritonJITFunction::run_compiler(const std::string& signature,
+                                            const CompileOptions& options,
+                                            unsigned int arch) const {
+  if (CompileWorkerPool* workers = CompileWorkerPool::get()) {
     try {
-      ans = fn(this->file_path_, this->function_name_, signature, num_warps, num_stages, device_index);
-    } catch (const py::error_already_set& e) {
-      std::cerr << "Python exception: " << e.what() << std::endl;
+      return workers->compile_kernel(this->source_path(), this->function_name_, signature, options, arch);
+    } catch (const CompileWorkerError& e) {
+      TRITON_JIT_LOG(WARNING) << fmt::format("{}, falling back to the embedded interpreter", e.what());
+    } catch (const std::runtime_error& e) {
+      throw std::runtime_error(fmt::format(
+          "Failed to compile {} with signature {}: {}", this->function_name_, signature, e.what()));
+    }
+  }
+
+  // embed python
+  namespace py = pybind11;
+  ensure_initialized();
+  py::gil_scoped_acquire gil;
+  ScopedTimer timer(this->interpreter_time_);
+
+  py::object ans;
+  try {
+    // the options other than num_warps & num_stages are passed as they are to triton.compile
+    py::dict extra_options;
+    for (const auto& [name, value] : options.items()) {
+      if (name != "num_warps" && name != "num_stages") {
+        extra_options[py::str(name)] = std::visit([](const auto& v) { return py::cast(v); }, value);
+      }
     }
-    std::string cache_dir = ans.cast<std::string>();
-    TritonKernel k(cache_dir, this->function_name_);
-    auto result = this->overloads_.emplace(std::move(key), std::move(k));
-    if (result.second) {
-      pos = result.first;
-    } else {
-      throw std::runtime_error("Unable to emplace the kernel into TritonJITFunction's cache");
+    // compiled for the arch, so that devices of the same arch share it
+    ans = compiler_session().compile_a_kernel(this->file_path_,
+                                              this->function_name_,
+                                              signature,
+                                              options.num_warps,
+                                              options.num_stages,
+                                              py::arg("target_arch") = arch,
+                                              py::arg("options") = extra_options);
+  } catch (const py::error_already_set& e) {
+    std::cerr << "Python exception: " << e.what() << std::endl;
+    throw std::runtime_error(fmt::format("Failed to compile {} with signature {}: {}",
+                                         this->function_name_,
+                                         signature,
+                                         e.what()));
+  }
+  return ans.cast<std::string>();
+}
+
+const TritonKernel* TritonJITFunction::publish_kernel(const KernelKey& key,
+                                                      std::unique_ptr<TritonKernel> kernel) const {
+  // the clock advances by 2, so that kernels used after this one is published are newer than it
+  kernel->last_used_.store(lru_clock_.fetch_add(2, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  const TritonKernel* published;
+  bool inserted;
+  {
+    std::unique_lock<ShardedSharedMutex> lock(this->overloads_mutex_);
+    // the first one wins if the same kernel is published twice
+    auto result = this->overloads_.try_emplace(key, std::move(kernel));
+    published = result.first->second.get();
+    inserted = result.second;
+  }
+  if (inserted) {
+    std::optional<SpecializationReport> churn = this->specializations_.record(
+        key.signature.to_signature(), this->max_variants_.load(std::memory_order_relaxed));
+    if (churn) {
+      TRITON_JIT_LOG(WARNING) << fmt::format(
+          "{} is compiled for more than {} signatures, recompiles are caused by the arguments that differ "
+          "between them: {}. Pointers get :16 by the alignment of tensors, integers by their values",
+          this->function_name_,
+          this->max_variants_.load(std::memory_order_relaxed),
+          churn->to_string());
     }
+    TritonJITFunction::num_cached_kernels_.fetch_add(1, std::memory_order_relaxed);
+    this->enforce_cache_bounds(published);
   }
-  return pos->second;
+  return published;
 }
 
-TritonJITFunction& TritonJITFunction::get_instance(std::string_view path, std::string_view name) {
-  std::string function_id = fmt::format("{}:{}", path, name);
-  auto pos = TritonJITFunction::functions_.find(function_id);
+void TritonJITFunction::set_max_kernels(size_t max_kernels) {
+  this->max_kernels_.store(max_kernels, std::memory_order_relaxed);
+  this->enforce_cache_bounds(nullptr);
+}
 
-  if (pos == TritonJITFunction::functions_.end()) {
-    TritonJITFunction f(path, name);
-    auto result = TritonJITFunction::functions_.emplace(std::move(function_id), std::move(f));
-    if (result.second) {
-      pos = result.first;
-    } else {
-      throw std::runtime_error("Unable to emplace the TritonJITFunction into Multiton cache.");
+void TritonJITFunction::set_max_cached_kernels(size_t max_kernels) {
+  TritonJITFunction::max_cached_kernels_.store(max_kernels, std::memory_order_relaxed);
+  TritonJITFunction::enforce_global_bound(nullptr);
+}
+
+size_t TritonJITFunction::num_kernels() const {
+  std::shared_lock<ShardedSharedMutex> lock(this->overloads_mutex_);
+  return this->overloads_.size();
+}
+
+void TritonJITFunction::enforce_cache_bounds(const TritonKernel* keep) const {
+  size_t max_kernels = this->max_kernels_.load(std::memory_order_relaxed);
+  while (max_kernels > 0 && this->num_kernels() > max_kernels) {
+    if (!this->evict_lru(keep)) {
+      break;
+    }
+  }
+  TritonJITFunction::enforce_global_bound(keep);
+}
+
+void TritonJITFunction::enforce_global_bound(const TritonKernel* keep) {
+  // the least recently used kernel of all functions goes first
+  size_t max_cached = TritonJITFunction::max_cached_kernels_.load(std::memory_order_relaxed);
+  while (max_cached > 0 &&
+         TritonJITFunction::num_cached_kernels_.load(std::memory_order_relaxed) > max_cached) {
+    const TritonJITFunction* victim = nullptr;
+    uint64_t oldest = 0;
+    {
+      std::shared_lock<ShardedSharedMutex> lock(TritonJITFunction::functions_mutex_);
+      for (const auto& [id, function] : TritonJITFunction::functions_) {
+        std::optional<uint64_t> last_use = function->oldest_use(keep);
+        if (last_use && (!victim || *last_use < oldest)) {
+          victim = function.get();
+          oldest = *last_use;
+        }
+      }
+    }
+    if (!victim || !victim->evict_lru(keep)) {
+      break;
+    }
+  }
+}
+
+std::optional<uint64_t> TritonJITFunction::oldest_use(const TritonKernel* keep) const {
+  std::optional<uint64_t> oldest;
+  std::shared_lock<ShardedSharedMutex> lock(this->overloads_mutex_);
+  for (const auto& [key, kernel] : this->overloads_) {
+    uint64_t last_use = kernel->last_used_.load(std::memory_order_relaxed);
+    if (kernel.get() != keep && (!oldest || last_use < *oldest)) {
+      oldest = last_use;
+    }
+  }
+  return oldest;
+}
+
+bool TritonJITFunction::evict_lru(const TritonKernel* keep) const {
+  KernelKey key;
+  std::unique_ptr<TritonKernel> kernel;
+  {
+    std::unique_lock<ShardedSharedMutex> lock(this->overloads_mutex_);
+    auto victim = this->overloads_.end();
+    for (auto it = this->overloads_.begin(); it != this->overloads_.end(); ++it) {
+      if (it->second.get() != keep &&
+          (victim == this->overloads_.end() ||
+           it->second->last_used_.load(std::memory_order_relaxed) <
+               victim->second->last_used_.load(std::memory_order_relaxed))) {
+        victim = it;
+      }
+    }
+    if (victim == this->overloads_.end()) {
+      return false;
     }
+    auto node = this->overloads_.extract(victim);
+    key = std::move(node.key());
+    kernel = std::move(node.mapped());
+  }
+  TritonJITFunction::num_cached_kernels_.fetch_sub(1, std::memory_order_relaxed);
+  this->evictions_.fetch_add(1, std::memory_order_release);
+  TRITON_JIT_LOG(INFO) << fmt::format(
+      "Evicting the kernel of {} with signature {}, {}",
+      this->function_name_,
+      key.signature.to_signature(),
+      key.options.to_string());
+
+  {
+    std::lock_guard<std::mutex> lock(this->retired_mutex_);
+    this->retired_.push_back(std::move(kernel));
+    this->has_retired_.store(true, std::memory_order_seq_cst);
   }
-  return pos->second;
+  // if a use is held, e.g. by the launch that published the new kernel, the last one to end frees it
+  this->free_retired();
+  return true;
+}
+
+void TritonJITFunction::retire(std::shared_ptr<const void> entry) const {
+  {
+    std::lock_guard<std::mutex> lock(this->retired_mutex_);
+    this->retired_entries_.push_back(std::move(entry));
+    this->has_retired_.store(true, std::memory_order_seq_cst);
+  }
+  this->free_retired();
+}
+
+void TritonJITFunction::free_retired() const {
+  std::unique_lock<std::mutex> lock(this->retired_mutex_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    return;
+  }
+  // pairs with the increment of ScopedKernelUse: a use that is not counted here began after the
+  // retired kernels & entries were evicted & replaced, so it cannot refer to them
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  for (const Users& shard : this->users_) {
+    if (shard.count.load(std::memory_order_seq_cst) != 0) {
+      return;
+    }
+  }
+  this->retired_.erase(
+      std::remove_if(this->retired_.begin(),
+                     this->retired_.end(),
+                     [](const std::unique_ptr<TritonKernel>& kernel) { return kernel->unload(); }),
+      this->retired_.end());
+  this->retired_entries_.clear();
+  this->has_retired_.store(!this->retired_.empty(), std::memory_order_seq_cst);
+}
+
+FunctionMetrics TritonJITFunction::metrics() const {
+  FunctionMetrics metrics {this->file_path_,
+                           this->function_name_,
+                           this->cache_hits_.value(),
+                           this->cache_misses_.value(),
+                           this->evictions_.load(std::memory_order_relaxed),
+                           0,
+                           this->compile_time_.snapshot(),
+                           this->interpreter_time_.snapshot(),
+                           {}};
+  std::shared_lock<ShardedSharedMutex> lock(this->overloads_mutex_);
+  // kernels of a signature differ in compile options or arch
+  std::unordered_set<std::string> signatures;
+  for (const auto& [key, kernel] : this->overloads_) {
+    const std::string& signature = *signatures.insert(key.signature.to_signature()).first;
+    metrics.kernels.push_back(KernelMetrics {signature,
+                                             key.options.num_warps,
+                                             key.options.num_stages,
+                                             key.options.to_string(),
+                                             key.arch,
+                                             kernel->launches_.value(),
+                                             kernel->load_time_.snapshot()});
+  }
+  metrics.num_signatures = signatures.size();
+  return metrics;
+}
+
+MetricsSnapshot TritonJITFunction::snapshot_metrics() {
+  MetricsSnapshot snapshot;
+  std::shared_lock<ShardedSharedMutex> lock(TritonJITFunction::functions_mutex_);
+  for (const auto& [id, function] : TritonJITFunction::functions_) {
+    snapshot.functions.push_back(function->metrics());
+  }
+  return snapshot;
+}
+
+TritonJITFunction& TritonJITFunction::get_instance(std::string_view path,
+                                                  std::string_view name,
+                                                  const SpecializationPolicy& policy) {
+  // functions with other policies are other instances
+  std::string function_id = policy.empty() ? fmt::format("{}:{}", path, name)
+                                           : fmt::format("{}:{}|{}", path, name, policy.to_string());
+  {
+    std::shared_lock<ShardedSharedMutex> lock(TritonJITFunction::functions_mutex_);
+    auto pos = TritonJITFunction::functions_.find(function_id);
+    if (pos != TritonJITFunction::functions_.end()) {
+      return *pos->second;
+    }
+  }
+
+  // construct it without holding the lock since it runs python code, which may wait for the GIL
+  std::unique_ptr<TritonJITFunction> f(new TritonJITFunction(path, name, policy));
+  std::unique_lock<ShardedSharedMutex> lock(TritonJITFunction::functions_mutex_);
+  auto result = TritonJITFunction::functions_.try_emplace(std::move(function_id), std::move(f));
+  return *result.first->second;
 }
 
 void TritonJITFunction::launch_with_raw_args(CUstream stream,
                                              unsigned int grid_x,
                                              unsigned int grid_y,
                                              unsigned int grid_z,
-                                             unsigned int num_warps,
-                                             unsigned int num_stages,
+                                             const CompileOptions& options,
                                              std::string full_signature,
                                              void** args) const {
-  CUcontext ctx;
-  checkCudaErrors(cuStreamGetCtx(stream, &ctx));
-  checkCudaErrors(cuCtxSetCurrent(ctx));
-  CUdevice d;
-  checkCudaErrors(cuCtxGetDevice(&d));
-  // LOG(INFO) << fmt::format("launching kernel");
-  const TritonKernel& kernel = this->get_kernel(full_signature, num_warps, num_stages, d);
-  kernel.launch(grid_x, grid_y, grid_z, num_warps, stream, args);
+  CUdevice d = Driver::get().stream_device(stream);
+  ScopedKernelUse use(*this);
+  const TritonKernel& kernel = this->get_kernel(full_signature, options, d);
+  kernel.launch(grid_x, grid_y, grid_z, options.num_warps, d, stream, args);
 }
 }  // namespace triton_jit
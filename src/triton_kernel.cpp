@@ -2,11 +2,14 @@
 
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <string>
 
-#include "c10/util/Logging.h"  // use torch's logging
 #include "fmt/core.h"
 #include "nlohmann/json.hpp"
+#include "triton_jit/driver.h"
+#include "triton_jit/logging.h"
+#include "triton_jit/trace.h"
 
 using json = nlohmann::json;
 
@@ -15,71 +18,90 @@ TritonKernel::TritonKernel(std::string_view dir, std::string_view kernel_name)
     : dir_(std::string(dir)), kernel_name_(std::string(kernel_name)) {
   std::string metadata_path = fmt::format("{}/{}.json", this->dir_, this->kernel_name_);
   std::ifstream f(metadata_path.c_str());
-  json meta_data = json::parse(f);
+  std::string metadata((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  json meta_data = json::parse(metadata);
 
   // shared and arch are bound to a kernel dir
   this->shared_ = meta_data["shared"];
   this->arch_ = meta_data["target"]["arch"];
-  // LOG(INFO) << fmt::format("TritonKernel Metadata loaded arch: {} shared: {}", this->arch_, this->shared_);
+  this->attributes_ = LaunchAttributes::from_metadata(metadata);
 }
 
-void TritonKernel::lazy_init_handle() const {
-  if (this->loaded_) {
-    return;
+TritonKernel::TritonKernel(std::string_view kernel_name,
+                           std::string_view metadata,
+                           const void* image,
+                           size_t image_size)
+    : kernel_name_(std::string(kernel_name)), cubin_(CubinImage::from_memory(image, image_size)) {
+  json meta_data = json::parse(metadata);
+  this->shared_ = meta_data["shared"];
+  this->arch_ = meta_data["target"]["arch"];
+  this->attributes_ = LaunchAttributes::from_metadata(metadata);
+}
+
+CUfunction TritonKernel::lazy_init_handle(CUdevice device_index) const {
+  if (device_index < 0 || device_index >= MAX_DEVICES) {
+    throw std::runtime_error(
+        fmt::format("Device {} is out of the {} devices supported", device_index, MAX_DEVICES));
+  }
+  DeviceHandle& handle = this->handles_[device_index];
+  // seq_cst pairs with unload, which clears the handle before it checks the launches in flight
+  if (CUfunction fn = handle.fn.load(std::memory_order_seq_cst)) {
+    return fn;
+  }
+  std::lock_guard<std::mutex> lock(this->load_mutex_);
+  if (CUfunction fn = handle.fn.load(std::memory_order_relaxed)) {
+    return fn;
   }
 
-  LOG(INFO) << fmt::format("TritonKernel {} at {} loading itself!",
-                           this->kernel_name_,
-                           reinterpret_cast<const void*>(this));
+  TRITON_JIT_LOG(INFO) << fmt::format("TritonKernel {} at {} loading itself into device {}!",
+                                      this->kernel_name_,
+                                      reinterpret_cast<const void*>(this),
+                                      device_index);
+  ScopedTimer timer(this->load_time_);
+  TraceSpan span("module_load", this->kernel_name_, {}, device_index, this->arch_);
   // check cuda arch
-  CUdevice device_index;
-  checkCudaErrors(cuCtxGetDevice(&device_index));
-  int major = 0, minor = 0;
-  checkCudaErrors(cuDeviceGetAttribute(&major, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR, device_index));
-  checkCudaErrors(cuDeviceGetAttribute(&minor, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR, device_index));
-  unsigned int arch = major * 10 + minor;
+  Driver& driver = Driver::get();
+  unsigned int arch = driver.device_arch(device_index);
   if (arch != this->arch_) {
     throw std::runtime_error("compute architecture mismatch!");
   }
 
-  // load module
-  std::string cubin_path = fmt::format("{}/{}.cubin", this->dir_, this->kernel_name_);
-  LOG(INFO) << fmt::format("Loading cubin {} into device {}", cubin_path, device_index);
-  checkCudaErrors(cuModuleLoad(&this->mod_, cubin_path.c_str()));
-
-  // get function
-  checkCudaErrors(cuModuleGetFunction(&this->fn_, this->mod_, this->kernel_name_.c_str()));
-
-  // check required shared memory does not exceeds max shared memory per block
-  int shared_optin;
-  cuDeviceGetAttribute(&shared_optin, CU_DEVICE_ATTRIBUTE_MAX_SHARED_MEMORY_PER_BLOCK_OPTIN, device_index);
-  if (this->shared_ > shared_optin) {
-    throw std::runtime_error(
-        fmt::format("Out0fResources: Requested shared memory ({}) bytes exceeds GPU's maximum ({}) bytes.",
-                    this->shared_,
-                    shared_optin));
+  // the cubin file is mapped once, and loaded once per device for all kernels of the same content
+  if (!this->cubin_) {
+    this->cubin_ = CubinImage::from_file(fmt::format("{}/{}.cubin", this->dir_, this->kernel_name_));
   }
+  // an unload deferred by a launch in flight keeps the module
+  if (!handle.mod) {
+    handle.mod = ModuleTable::get().load(device_index, this->cubin_);
+  }
+  CUfunction fn = driver.get_function(device_index, handle.mod, this->kernel_name_, this->shared_);
+  handle.fn.store(fn, std::memory_order_release);
+  return fn;
+}
 
-  // increase shared memory if required
-  if (this->shared_ > 49152 && shared_optin > 49152) {
-    LOG(INFO) << fmt::format(
-        "Condition met: this->shared_ ={} && shared_optin = {}. Setting CU_FUNC_CACHE_PREFER_SHARED.",
-        this->shared_,
-        shared_optin);
-    checkCudaErrors(cuFuncSetCacheConfig(this->fn_, CU_FUNC_CACHE_PREFER_SHARED));
-    int shared_total, shared_static;
-    checkCudaErrors(cuDeviceGetAttribute(&shared_total,
-                                         CU_DEVICE_ATTRIBUTE_MAX_SHARED_MEMORY_PER_MULTIPROCESSOR,
-                                         device_index));
-    checkCudaErrors(cuFuncGetAttribute(&shared_static, CU_FUNC_ATTRIBUTE_SHARED_SIZE_BYTES, this->fn_));
-    LOG(INFO) << fmt::format("current shared memory total {}", shared_total);
-    LOG(INFO) << fmt::format("current shared memory static {}", shared_static);
-    checkCudaErrors(cuFuncSetAttribute(this->fn_,
-                                       CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES,
-                                       shared_optin - shared_static));
-    LOG(INFO) << fmt::format("shared memory to add {}", shared_optin - shared_static);
+bool TritonKernel::unload() const {
+  std::lock_guard<std::mutex> lock(this->load_mutex_);
+  for (DeviceHandle& handle : this->handles_) {
+    handle.fn.store(nullptr, std::memory_order_seq_cst);
+  }
+  // a launch that got a function before it was cleared is counted here
+  for (const InFlight& shard : this->in_flight_) {
+    if (shard.count.load(std::memory_order_seq_cst) != 0) {
+      return false;
+    }
   }
-  this->loaded_ = true;
+  for (int device = 0; device < MAX_DEVICES; device++) {
+    DeviceHandle& handle = this->handles_[device];
+    if (handle.mod) {
+      ModuleTable::get().release(device, *this->cubin_);
+      handle.mod = nullptr;
+    }
+  }
+  // a kernel from a directory maps its cubin again on its next load
+  if (!this->dir_.empty()) {
+    this->cubin_.reset();
+  }
+  return true;
 }
 
 // consider using a variadic template
@@ -87,21 +109,106 @@ void TritonKernel::launch(unsigned int grid_x,
                           unsigned int grid_y,
                           unsigned int grid_z,
                           int num_warps,
+                          CUdevice device_index,
                           CUstream stream,
                           void** args) const {
-  this->lazy_init_handle();
-
-  LOG(INFO) << "cuLaunchKernel";
-  checkCudaErrors(cuLaunchKernel(this->fn_,
-                                 /*grid*/ grid_x,
-                                 grid_y,
-                                 grid_z,
-                                 /*block*/ 32 * num_warps,
-                                 1,
-                                 1,
-                                 /*shared & stream*/ this->shared_,
-                                 /*stream*/ stream,
-                                 /*args*/ args,
-                                 nullptr));
+  TraceSpan span("launch", this->kernel_name_, {}, device_index);
+  InFlightGuard in_flight(*this);
+  CUfunction fn = this->lazy_init_handle(device_index);
+  this->launches_.add();
+
+  TRITON_JIT_VLOG << fmt::format(
+      "Launching {} on grid ({}, {}, {})", this->kernel_name_, grid_x, grid_y, grid_z);
+  if (this->attributes_.plain()) {
+    Driver::get().launch(fn, grid_x, grid_y, grid_z, 32 * num_warps, this->shared_, stream, args);
+  } else {
+    Driver::get().launch_with_attributes(fn,
+                                         grid_x,
+                                         grid_y,
+                                         grid_z,
+                                         32 * num_warps,
+                                         this->shared_,
+                                         stream,
+                                         args,
+                                         nullptr,
+                                         0,
+                                         this->attributes_);
+  }
+}
+
+void TritonKernel::launch_packed(unsigned int grid_x,
+                                 unsigned int grid_y,
+                                 unsigned int grid_z,
+                                 int num_warps,
+                                 CUdevice device_index,
+                                 CUstream stream,
+                                 void* params,
+                                 size_t params_size) const {
+  TraceSpan span("launch", this->kernel_name_, {}, device_index);
+  InFlightGuard in_flight(*this);
+  CUfunction fn = this->lazy_init_handle(device_index);
+  this->launches_.add();
+
+  TRITON_JIT_VLOG << fmt::format(
+      "Launching {} on grid ({}, {}, {}) with packed parameters", this->kernel_name_, grid_x, grid_y, grid_z);
+  if (this->attributes_.plain()) {
+    Driver::get().launch_packed(
+        fn, grid_x, grid_y, grid_z, 32 * num_warps, this->shared_, stream, params, params_size);
+  } else {
+    Driver::get().launch_with_attributes(fn,
+                                         grid_x,
+                                         grid_y,
+                                         grid_z,
+                                         32 * num_warps,
+                                         this->shared_,
+                                         stream,
+                                         nullptr,
+                                         params,
+                                         params_size,
+                                         this->attributes_);
+  }
+}
+
+void TritonKernel::launch_many(const BatchedLaunch* items,
+                               size_t num_items,
+                               int num_warps,
+                               CUdevice device_index,
+                               CUstream stream) const {
+  Driver& driver = Driver::get();
+  TraceSpan span("launch_many", this->kernel_name_, {}, device_index);
+  InFlightGuard in_flight(*this);
+  CUfunction fn = this->lazy_init_handle(device_index);
+  this->launches_.add(num_items);
+
+  TRITON_JIT_VLOG << fmt::format("Launching {} {} times", this->kernel_name_, num_items);
+  for (size_t i = 0; i < num_items; i++) {
+    const BatchedLaunch& item = items[i];
+    if (!this->attributes_.plain()) {
+      driver.launch_with_attributes(fn,
+                                    item.grid[0],
+                                    item.grid[1],
+                                    item.grid[2],
+                                    32 * num_warps,
+                                    this->shared_,
+                                    stream,
+                                    item.args,
+                                    item.params,
+                                    item.params_size,
+                                    this->attributes_);
+    } else if (item.args) {
+      driver.launch(
+          fn, item.grid[0], item.grid[1], item.grid[2], 32 * num_warps, this->shared_, stream, item.args);
+    } else {
+      driver.launch_packed(fn,
+                           item.grid[0],
+                           item.grid[1],
+                           item.grid[2],
+                           32 * num_warps,
+                           this->shared_,
+                           stream,
+                           item.params,
+                           item.params_size);
+    }
+  }
 }
 }  // namespace triton_jit